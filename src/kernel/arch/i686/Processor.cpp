@@ -6,6 +6,7 @@
 
 #include <interrupts/LAPIC.hpp>
 #include <logging/logger.hpp>
+#include <memory/KernelStackPool.hpp>
 #include <memory/VirtualMemoryManager.hpp>
 
 #include <sys/syscall.h>
@@ -19,8 +20,6 @@ extern "C"
 
 namespace Kernel::CPU
 {
-	static std::atomic<uint64_t> s_nanoseconds_since_boot;
-
 	class APICIPIInterruptHandler final : public Interrupts::InterruptHandler
 	{
 	public:
@@ -50,16 +49,6 @@ namespace Kernel::CPU
 	static uint32_t s_core_count = 1;
 	static APICIPIInterruptHandler s_ipi_handler;
 
-	Processor &Processor::current()
-	{
-		// TODO: Fix dependency on the LAPIC for the CPU id
-		if (s_core_count == 1)
-			return s_bsp;
-
-		size_t id = Interrupts::LAPIC::instance().get_ap_id();
-		return by_id(id);
-	}
-
 	void Processor::set_core_count(uint32_t core_count)
 	{
 		uint32_t old_count = s_core_count;
@@ -85,9 +74,18 @@ namespace Kernel::CPU
 	{
 		Processor &core = by_id(id);
 		core.m_id = id;
-		core.m_page_fault_stack = new char[PAGE_SIZE];
+
+		// Comes first, as everything else may call current()
 		core.init_gdt();
+
+		core.m_page_fault_stack = new char[PAGE_SIZE];
+		core.m_page_fault_tss.esp = reinterpret_cast<uint32_t>(core.m_page_fault_stack + PAGE_SIZE - sizeof(uintptr_t));
+		core.m_page_fault_tss.ebp = core.m_page_fault_tss.esp;
+
 		core.init_idt();
+
+		// Before anything on this core can unmap memory
+		Memory::Arch::initialize_shootdowns();
 	}
 
 	uint32_t Processor::count()
@@ -115,20 +113,24 @@ namespace Kernel::CPU
 		}
 	}
 
-	uint64_t Processor::get_nanoseconds_since_boot()
+	void Processor::smp_initialize_messaging()
 	{
-		return s_nanoseconds_since_boot;
+		s_ipi_handler.register_handler();
 	}
 
-	void Processor::increment_nanoseconds_since_boot(uint64_t increment)
+	void Processor::set_memory_space(Memory::memory_space_t *memory_space)
 	{
-		assert(m_id == 0);
-		s_nanoseconds_since_boot += increment;
-	}
+		// The bit is set before the space gets loaded, so a shootdown that misses it happened before this core could cache any of its entries
+		if (m_id < Memory::Arch::ACTIVE_CORE_LIMIT && m_memory_space != memory_space)
+		{
+			if (m_memory_space && m_memory_space->paging_space.active_cores)
+				m_memory_space->paging_space.active_cores->fetch_and(~(1u << m_id));
 
-	void Processor::smp_initialize_messaging()
-	{
-		s_ipi_handler.register_handler();
+			if (memory_space && memory_space->paging_space.active_cores)
+				memory_space->paging_space.active_cores->fetch_or(1u << m_id);
+		}
+
+		m_memory_space = memory_space;
 	}
 
 	void Processor::smp_poke()
@@ -158,30 +160,51 @@ namespace Kernel::CPU
 	void Processor::smp_enqueue_message(LibK::shared_ptr<ProcessorMessage> message)
 	{
 		// log("SMP", "Enqueueing message on (#%d)", this->id());
-		m_queued_messages.put(std::move(message));
+		// try_put leaves the message untouched on failure.
+		// The own ring is drained while waiting, the target may itself be waiting on a full ring of this core
+		while (!m_queued_messages.try_put(std::move(message)))
+			relax();
 	}
 
 	void Processor::smp_process_messages()
 	{
 		// log("SMP", "Processing SMP messages");
 
-		while (!m_queued_messages.empty())
-		{
-			m_queued_messages.get()->handle();
-		}
+		LibK::shared_ptr<ProcessorMessage> message;
+
+		while (m_queued_messages.try_get(message))
+			message->handle();
 	}
 
-	void Processor::defer_call(LibK::function<void()> &&callback)
+	void Processor::relax()
 	{
-		m_deferred_calls.put(std::move(callback));
+		current().smp_process_messages();
+		pause();
 	}
 
-	void Processor::process_deferred_queue()
+	void Processor::defer_call(LibK::function<void()> &&callback)
 	{
-		while (!m_deferred_calls.empty())
+		if (m_deferred_calls.try_put(std::move(callback)))
+			return;
+
+		// Many timers may expire at once, a full ring is drained in place and the call runs right after it.
+		// Once interrupts nest, the scheduler below might be in the middle of consuming the ring, the call only runs inline then
+		if (get_irq_counter() <= 1)
 		{
-			m_deferred_calls.get()();
+			enter_critical();
+			process_deferred_queue();
+			leave_critical();
 		}
+
+		callback();
+	}
+
+	void Processor::process_deferred_queue()
+	{
+		LibK::function<void()> callback;
+
+		while (m_deferred_calls.try_get(callback))
+			callback();
 	}
 
 	thread_registers_t Processor::create_initial_state(uintptr_t stack_ptr, uintptr_t main_ptr, bool is_userspace_thread, Memory::Arch::paging_space_t paging_space)
@@ -192,7 +215,7 @@ namespace Kernel::CPU
 		return {
 		    .cs = cs,
 		    .ss = ds,
-		    .gs = ds,
+		    .gs = is_userspace_thread ? ds : PER_CPU_SELECTOR,
 		    .fs = ds,
 		    .es = ds,
 		    .ds = ds,
@@ -237,7 +260,7 @@ namespace Kernel::CPU
 
 	thread_t *Processor::create_kernel_thread(uintptr_t main_function)
 	{
-		auto stack_region = Memory::VirtualMemoryManager::instance().allocate_region(KERNEL_STACK_SIZE);
+		auto stack_region = Memory::KernelStackPool::instance().allocate();
 		uintptr_t stack = stack_region.virt_address + KERNEL_STACK_SIZE - sizeof(uintptr_t);
 
 		return new thread_t{
@@ -251,6 +274,15 @@ namespace Kernel::CPU
 		};
 	}
 
+	void Processor::release_kernel_stack(thread_t *thread)
+	{
+		// Kernel stacks of userspace threads belong to the memory space of their process
+		if (thread->kernel_stack_region.virt_address < (uintptr_t)&_virtual_addr)
+			return;
+
+		Memory::KernelStackPool::instance().release(thread->kernel_stack_region);
+	}
+
 	thread_t *Processor::create_userspace_thread(Memory::memory_space_t &memory_space)
 	{
 		Memory::mapping_config_t config;
@@ -528,6 +560,7 @@ namespace Kernel::CPU
 		    "mov %%ax, %%ds\n"
 		    "mov %%ax, %%es\n"
 		    "mov %%ax, %%fs\n"
+		    "movl %[gs], %%eax\n"
 		    "mov %%ax, %%gs\n"
 		    "movl %[ss], %%eax\n"
 		    "cmp $0x10, %%eax\n"
@@ -564,6 +597,7 @@ namespace Kernel::CPU
 		    "iret\n"
 		    :
 		    : [ds] "m"(thread.registers.ds),
+		      [gs] "m"(thread.registers.gs),
 		      [ebp] "m"(thread.registers.ebp),
 		      [ss] "m"(thread.registers.ss),
 		      [esp] "m"(thread.registers.esp),
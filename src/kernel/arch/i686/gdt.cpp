@@ -9,6 +9,12 @@ namespace Kernel::CPU
 {
 	static char *abort_stack[PAGE_SIZE];
 
+	// Used by the BSP until early_initialize, as the constructors that run in between reset the BSP instance.
+	// All of these are plain data, so they are never touched by a constructor themselves
+	static gdt_entry_t s_boot_gdt[GDT_ENTRY_COUNT];
+	static gdt_descriptor_t s_boot_gdtr;
+	static Processor *s_boot_self;
+
 	always_inline static gdt_entry_t create_gdt_selector(uint8_t privilege, bool is_code)
 	{
 		return gdt_entry_t{
@@ -47,8 +53,56 @@ namespace Kernel::CPU
 		};
 	}
 
+	always_inline static gdt_entry_t create_per_cpu_selector(uint32_t base)
+	{
+		gdt_entry_t entry = create_gdt_selector(0, false);
+		entry.base_low = base & 0xFFFFFF;
+		entry.base_high = (base >> 24) & 0xFF;
+
+		return entry;
+	}
+
+	always_inline static void reload_segments()
+	{
+		asm volatile(
+		    "push $0x08\n"
+		    "lea %=f, %%eax\n"
+		    "push %%eax\n"
+		    "retf\n"
+		    "%=:\n"
+		    "mov $0x10, %%ax\n"
+		    "mov %%ax, %%ss\n"
+		    "mov %%ax, %%ds\n"
+		    "mov %%ax, %%es\n"
+		    "mov %%ax, %%fs\n"
+		    "mov %%bx, %%gs\n"
+		    : : "a"(0), "b"(PER_CPU_SELECTOR) : "memory");
+	}
+
+	void Processor::install_boot_gdt()
+	{
+		s_boot_self = &by_id(0);
+
+		s_boot_gdt[0] = gdt_entry_t();
+		s_boot_gdt[1] = create_gdt_selector(0, true);
+		s_boot_gdt[2] = create_gdt_selector(0, false);
+		s_boot_gdt[3] = create_gdt_selector(3, true);
+		s_boot_gdt[4] = create_gdt_selector(3, false);
+		s_boot_gdt[8] = create_per_cpu_selector((uint32_t)&s_boot_self);
+
+		s_boot_gdtr.size = sizeof(s_boot_gdt);
+		s_boot_gdtr.offset = (uint32_t)&s_boot_gdt;
+
+		asm volatile("lgdt %0" ::"m"(s_boot_gdtr)
+		             : "memory");
+
+		reload_segments();
+	}
+
 	void Processor::init_gdt()
 	{
+		m_self = this;
+
 		memset(&m_tss, 0, sizeof(tss_entry_t));
 		m_tss.ss0 = 0x10;
 		m_tss.iopb = sizeof(tss_entry_t);
@@ -61,6 +115,7 @@ namespace Kernel::CPU
 		m_gdt[5] = create_tss((uint32_t)&m_tss, sizeof(tss_entry_t));
 		m_gdt[6] = create_tss((uint32_t)&m_abort_tss, sizeof(tss_entry_t));
 		m_gdt[7] = create_tss((uint32_t)&m_page_fault_tss, sizeof(tss_entry_t));
+		m_gdt[8] = create_per_cpu_selector((uint32_t)&m_self);
 
 		m_gdtr.size = sizeof(m_gdt);
 		m_gdtr.offset = (uint32_t)&m_gdt;
@@ -73,19 +128,7 @@ namespace Kernel::CPU
 		    : : "a" (0x28)
 		    :);
 
-		asm volatile(
-		    "push $0x08\n"
-		    "lea %=f, %%eax\n"
-		    "push %%eax\n"
-		    "retf\n"
-		    "%=:\n"
-		    "mov $0x10, %%ax\n"
-		    "mov %%ax, %%ss\n"
-		    "mov %%ax, %%ds\n"
-		    "mov %%ax, %%es\n"
-		    "mov %%ax, %%fs\n"
-		    "mov %%ax, %%gs\n"
-		    : : "a"(0) : );
+		reload_segments();
 
 		memset(&m_abort_tss, 0, sizeof(tss_entry_t));
 		m_abort_tss.cs = 0x08;
@@ -94,7 +137,7 @@ namespace Kernel::CPU
 		m_abort_tss.ds = 0x08;
 		m_abort_tss.es = 0x08;
 		m_abort_tss.fs = 0x08;
-		m_abort_tss.gs = 0x08;
+		m_abort_tss.gs = PER_CPU_SELECTOR;
 		m_abort_tss.esp = reinterpret_cast<uint32_t>(abort_stack + PAGE_SIZE - sizeof(uintptr_t));
 		m_abort_tss.ebp = m_abort_tss.esp;
 		m_abort_tss.eflags = Processor::eflags();
@@ -102,10 +145,9 @@ namespace Kernel::CPU
 		m_abort_tss.cr3 = Processor::get_page_directory();
 		m_abort_tss.iopb = sizeof(tss_entry_t);
 
+		// The stack is set once it has been allocated, the heap cannot be used before the GDT is installed
 		memcpy(&m_page_fault_tss, &m_abort_tss, sizeof(tss_entry_t));
-		m_page_fault_tss.esp = reinterpret_cast<uint32_t>(m_page_fault_stack + PAGE_SIZE - sizeof(uintptr_t));
 		m_page_fault_tss.eip = reinterpret_cast<uint32_t>(isr_0x0E_entry);
-		m_page_fault_tss.ebp = m_page_fault_tss.esp;
 	}
 
 	void Processor::update_tss(uint32_t esp0)
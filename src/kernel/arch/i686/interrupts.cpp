@@ -9,6 +9,7 @@
 #include <common_attributes.h>
 #include <interrupts/SharedIRQHandler.hpp>
 #include <interrupts/UnhandledInterruptHandler.hpp>
+#include <memory/VirtualMemoryManager.hpp>
 #include <syscall/SyscallDispatcher.hpp>
 
 #include <libk/kcstdio.hpp>
@@ -49,6 +50,9 @@
 	PRINT_REGISTER(tag, name, old_esp); \
 	PRINT_REGISTER(tag, name, eip)
 
+#define PAGE_FAULT_PRESENT (1 << 0)
+#define PAGE_FAULT_WRITE   (1 << 1)
+
 extern "C"
 {
 	extern uintptr_t _virtual_addr;
@@ -117,6 +121,19 @@ namespace Kernel::CPU
 		{
 		}
 
+		void handle_interrupt(const CPU::interrupt_frame_t &reg) override
+		{
+			// Reserved memory is only backed once it gets touched and shared memory is only copied once it gets written to,
+			// both may also happen from within the kernel
+			bool is_present = reg.error_code & PAGE_FAULT_PRESENT;
+			bool is_write = reg.error_code & PAGE_FAULT_WRITE;
+
+			if ((!is_present || is_write) && Memory::VirtualMemoryManager::instance().handle_page_fault(Processor::cr2(), is_present))
+				return;
+
+			ExceptionHandler::handle_interrupt(reg);
+		}
+
 		void handle_kernel_exception(const CPU::interrupt_frame_t &reg) override
 		{
 			uintptr_t address = Processor::cr2();
@@ -216,6 +233,7 @@ namespace Kernel::CPU
 		    "mov %ax, %ds\n"
 		    "mov %ax, %es\n"
 		    "mov %ax, %fs\n"
+		    "mov $0x40, %ax\n"
 		    "mov %ax, %gs\n"
 		    "pushl %esp\n"
 		    "cld\n"
@@ -256,8 +274,6 @@ namespace Kernel::CPU
 		if (!handler)
 			unhandled_interrupt_handler(regs);
 
-		Memory::Arch::check_page_directory();
-
 		handler->handle_interrupt(*regs);
 		core.enter_critical();
 		core.get_interrupt_frame_stack().pop();
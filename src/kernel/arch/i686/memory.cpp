@@ -1,9 +1,14 @@
 #include <arch/memory.hpp>
 
+#include <atomic>
+
+#include <arch/PerCPU.hpp>
 #include <arch/Processor.hpp>
+#include <arch/i686/cpuid.hpp>
 #include <arch/i686/msr.hpp>
 #include <arch/spinlock.hpp>
 #include <common_attributes.h>
+#include <locking/TicketLock.hpp>
 #include <logging/logger.hpp>
 #include <memory/PhysicalMemoryManager.hpp>
 
@@ -15,9 +20,8 @@
 #include <libk/kmemory.hpp>
 #include <libk/kvector.hpp>
 
-#define PAGE_COUNT     1024
-#define PAGE_SIZE_HUGE (PAGE_SIZE * PAGE_COUNT)
-#define TABLE_SIZE     PAGE_SIZE_HUGE
+#define PAGE_COUNT 1024
+#define TABLE_SIZE PAGE_SIZE_HUGE
 
 #define OFFSET_BITS    12
 #define TABLE_BITS     10
@@ -30,7 +34,17 @@
 #define PAGE_DIRECTORY_ADDR   0xFFFFF000
 #define PAGE_TABLE_ARRAY_ADDR 0xFFC00000
 
-#define FIXED_PAGE_TABLE_MAP_ADDR (PAGE_TABLE_ARRAY_ADDR - PAGE_SIZE)
+// Each core gets its own window to map page tables of other paging spaces, counting down from the page table array,
+// and a cacheable one for the contents of data pages, counting up from the start of the fixed mapping table
+#define FIXED_MAPPING_ADDR                 (PAGE_TABLE_ARRAY_ADDR - TABLE_SIZE)
+#define FIXED_PAGE_TABLE_MAP_ADDR(core_id) (PAGE_TABLE_ARRAY_ADDR - PAGE_SIZE * ((core_id) + 1))
+#define FIXED_DATA_MAP_ADDR(core_id)       (FIXED_MAPPING_ADDR + PAGE_SIZE * (core_id))
+
+#define CR4_PSE (1 << 4)
+#define CR4_PGE (1 << 7)
+
+// Above this amount of pages a full TLB flush is cheaper than invalidating every page
+#define TLB_FLUSH_ALL_THRESHOLD 32
 
 #define PAT_MODE_UNCACHEABLE     0
 #define PAT_MODE_WRITE_COMBINING 1
@@ -53,36 +67,45 @@ extern "C"
 	extern uintptr_t _kernel_end;
 }
 
-// TODO: Refactor this to use the same page tables for kernel addresses
-
 namespace Kernel::Memory::Arch
 {
-	class PageInvalidatedMessage final : public CPU::ProcessorMessage
+	static void flush_range(uintptr_t virt_addr, size_t size, bool include_global);
+
+	class TLBShootdownMessage final : public CPU::ProcessorMessage
 	{
 	public:
-		explicit PageInvalidatedMessage(uintptr_t address)
-		    : m_address(address)
+		TLBShootdownMessage() = default;
+
+		// A physical_pd_address of 0 denotes kernel space, which is present in every paging space.
+		// Each core reuses its own message, which may only be changed once the previous shootdown has been acknowledged
+		void prepare(uintptr_t physical_pd_address, uintptr_t address, size_t size)
 		{
+			assert(is_acknowledged());
+
+			m_physical_pd_address = physical_pd_address;
+			m_address = address;
+			m_size = size;
 		}
 
 		void handle() override
 		{
-			CPU::Processor::invalidate_address(m_address);
-			// log("SMP", "Invalidated page %p", m_address);
+			// The core might have switched to another paging space since the message was sent
+			if (!m_physical_pd_address || CPU::Processor::get_page_directory() == m_physical_pd_address)
+				flush_range(m_address, m_size, !m_physical_pd_address);
+
+			m_pending_acks.fetch_sub(1, std::memory_order_release);
+			// log("SMP", "Invalidated range %p-%p", m_address, m_address + m_size);
 		}
 
+		void add_recipient() { m_pending_acks.fetch_add(1, std::memory_order_relaxed); }
+		[[nodiscard]] bool is_acknowledged() const { return m_pending_acks.load(std::memory_order_acquire) == 0; }
+
 	private:
+		uintptr_t m_physical_pd_address{};
 		uintptr_t m_address{};
-	};
+		size_t m_size{};
 
-	class DirectoryInvalidatedMessage final : public CPU::ProcessorMessage
-	{
-	public:
-		void handle() override
-		{
-			check_page_directory();
-			log("SMP", "Synchronized page directory");
-		}
+		std::atomic<uint32_t> m_pending_acks{0};
 	};
 
 	inline static constexpr size_t to_page_address(uintptr_t phys_addr);
@@ -97,27 +120,46 @@ namespace Kernel::Memory::Arch
 
 	inline static page_directory_t &get_page_directory_for(paging_space_t &memory_space);
 	inline static page_table_t &get_page_table_for(paging_space_t &memory_space, size_t pd_index);
+	inline static void *map_fixed_page(uintptr_t phys_addr);
+	inline static void *map_fixed_data_page(uintptr_t phys_addr);
+	inline static void *map_fixed_window(uintptr_t map_address, uintptr_t phys_addr, CachingMode caching_mode);
 
 	inline static bool get_write_through_from_pat_index(uint8_t pat_index);
 	inline static bool get_cache_disable_from_pat_index(uint8_t pat_index);
 	inline static bool get_page_attribute_from_pat_index(uint8_t pat_index);
 
 	inline static page_directory_entry_t raw_create_pde(uintptr_t table_addr, bool is_user, bool is_writeable, uint8_t caching_mode);
-	inline static page_table_entry_t raw_create_pte(uintptr_t page_addr, bool is_user, bool is_writeable, uint8_t caching_mode);
+	inline static page_directory_entry_t raw_create_huge_pde(uintptr_t page_addr, bool is_user, bool is_writeable, bool is_global, uint8_t caching_mode);
+	inline static page_table_entry_t raw_create_pte(uintptr_t page_addr, bool is_user, bool is_writeable, bool is_global, uint8_t caching_mode);
 
 	static page_directory_entry_t create_pde(size_t pd_index, paging_space_t &memory_space, bool is_user, bool is_writeable, uint8_t caching_mode);
-	static page_table_entry_t create_pte(uintptr_t page_address, page_directory_entry_t &pde, bool is_user, bool is_writeable, uint8_t caching_mode);
+	static page_table_entry_t create_pte(uintptr_t page_address, page_directory_entry_t &pde, bool is_user, bool is_writeable, bool is_global, uint8_t caching_mode);
 
 	static void for_page_in_range(uintptr_t virt_addr, size_t size, LibK::function<void(uintptr_t)> callback);
 
+	static bool is_page_table_empty(page_table_t &page_table);
+	static void unmap_range(paging_space_t &memory_space, uintptr_t virt_addr, size_t size, bool is_sparse, const LibK::function<void(uintptr_t)> &callback, const LibK::function<void(size_t)> &swap_callback);
+	static page_table_entry_t *get_pte(paging_space_t &memory_space, uintptr_t virt_addr);
+	static bool try_map_huge_page(paging_space_t &memory_space, uintptr_t phys_addr, uintptr_t virt_addr, uintptr_t page_limit, mapping_config_t config);
+	static void set_kernel_pde(size_t pd_index, page_directory_entry_t pde);
+
 	static uint8_t caching_mode_to_pat_index(CachingMode mode);
 
 	static paging_space_t s_kernel_paging_space{};
 
-	static Locking::Spinlock s_page_directory_lock{};
+	// Allocated up front, so shootdowns never touch the heap
+	static CPU::PerCPU<LibK::shared_ptr<TLBShootdownMessage>> s_shootdown_messages{};
+
+	// Kernel page tables are preallocated and shared by every paging space, as such the kernel half of a page directory
+	// only changes when a huge page replaces an empty page table. These rare changes are written into every directory.
+	static Locking::TicketLock s_page_directory_lock{"page directory"};
 	static page_directory_t *s_master_page_directory;
 	static page_table_t *s_master_mapping_table;
-	static uint64_t s_page_directory_version;
+	static LibK::vector<page_directory_t *> s_page_directories{};
+
+	// Kernel pages are the same in every paging space, so they can survive CR3 reloads when supported
+	static bool s_global_pages{false};
+	static bool s_huge_pages{false};
 
 	inline static bool is_kernel_space(uintptr_t virt_addr)
 	{
@@ -166,8 +208,29 @@ namespace Kernel::Memory::Arch
 
 	inline static page_table_t &get_page_table_for(paging_space_t &memory_space, size_t pd_index)
 	{
-		constexpr uintptr_t map_pd_index = get_pd_index(FIXED_PAGE_TABLE_MAP_ADDR);
-		constexpr uintptr_t map_pt_index = get_pt_index(FIXED_PAGE_TABLE_MAP_ADDR);
+		return *(page_table_t *)map_fixed_page((uintptr_t)memory_space.mapping_table->pages[pd_index].page());
+	}
+
+	inline static void *map_fixed_page(uintptr_t phys_addr)
+	{
+		// Page tables are mapped uncacheable everywhere, so the window has to match
+		return map_fixed_window(FIXED_PAGE_TABLE_MAP_ADDR(CPU::Processor::current().id()), phys_addr, CachingMode::Uncacheable);
+	}
+
+	inline static void *map_fixed_data_page(uintptr_t phys_addr)
+	{
+		return map_fixed_window(FIXED_DATA_MAP_ADDR(CPU::Processor::current().id()), phys_addr, CachingMode::WriteBack);
+	}
+
+	inline static void *map_fixed_window(uintptr_t map_address, uintptr_t phys_addr, CachingMode caching_mode)
+	{
+		// NOTE: The windows are per core, so we may not get preempted while the returned page is in use
+		auto &processor = CPU::Processor::current();
+		assert(processor.in_critical());
+		assert(processor.id() < PAGE_COUNT / 2);
+
+		size_t map_pd_index = get_pd_index(map_address);
+		size_t map_pt_index = get_pt_index(map_address);
 
 		auto &page_directory = get_page_directory();
 
@@ -175,10 +238,11 @@ namespace Kernel::Memory::Arch
 
 		auto &page_table = get_page_table(map_pd_index);
 
-		page_table[map_pt_index] = create_pte((uintptr_t)memory_space.mapping_table->pages[pd_index].page(), page_directory[map_pd_index], false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+		page_table[map_pt_index] = create_pte(phys_addr, page_directory[map_pd_index], false, true, false, caching_mode_to_pat_index(caching_mode));
 
-		invalidate(FIXED_PAGE_TABLE_MAP_ADDR);
-		return *(page_table_t *)FIXED_PAGE_TABLE_MAP_ADDR;
+		// No other core uses this window, so there is no need to shoot down other TLBs
+		CPU::Processor::invalidate_address(map_address);
+		return (void *)map_address;
 	}
 
 	inline static bool get_write_through_from_pat_index(uint8_t pat_index)
@@ -205,12 +269,33 @@ namespace Kernel::Memory::Arch
 		    .write_through = get_write_through_from_pat_index(pat_index),
 		    .cache_disable = get_cache_disable_from_pat_index(pat_index),
 		    .accessed = false,
+		    .dirty = false,
 		    .page_size = false,
+		    .global = false,
 		    .page_table_address = (uint32_t)table_addr >> OFFSET_BITS,
 		};
 	}
 
-	inline static page_table_entry_t raw_create_pte(uintptr_t page_addr, bool is_user, bool is_writeable, uint8_t pat_index)
+	inline static page_directory_entry_t raw_create_huge_pde(uintptr_t page_addr, bool is_user, bool is_writeable, bool is_global, uint8_t pat_index)
+	{
+		assert(page_addr % PAGE_SIZE_HUGE == 0);
+
+		// NOTE: For 4 MiB pages the PAT bit is the lowest bit of the address field
+		return page_directory_entry_t{
+		    .present = true,
+		    .writeable = is_writeable,
+		    .user = is_user,
+		    .write_through = get_write_through_from_pat_index(pat_index),
+		    .cache_disable = get_cache_disable_from_pat_index(pat_index),
+		    .accessed = false,
+		    .dirty = false,
+		    .page_size = true,
+		    .global = is_global,
+		    .page_table_address = ((uint32_t)page_addr >> OFFSET_BITS) | get_page_attribute_from_pat_index(pat_index),
+		};
+	}
+
+	inline static page_table_entry_t raw_create_pte(uintptr_t page_addr, bool is_user, bool is_writeable, bool is_global, uint8_t pat_index)
 	{
 		return page_table_entry_t{
 		    .present = true,
@@ -221,7 +306,8 @@ namespace Kernel::Memory::Arch
 		    .accessed = false,
 		    .dirty = false,
 		    .page_attribute = get_page_attribute_from_pat_index(pat_index),
-		    .global = false,
+		    .global = is_global,
+		    .swapped = false,
 		    .page_address = (uint32_t)page_addr >> OFFSET_BITS,
 		};
 	}
@@ -231,7 +317,7 @@ namespace Kernel::Memory::Arch
 		uintptr_t table_addr = (uintptr_t)PhysicalMemoryManager::instance().alloc(PAGE_SIZE);
 
 		auto &mapping_table = *memory_space.mapping_table;
-		mapping_table[pd_index] = raw_create_pte(table_addr, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+		mapping_table[pd_index] = raw_create_pte(table_addr, false, true, false, caching_mode_to_pat_index(CachingMode::Uncacheable));
 
 		// Clear it immediately to prevent bugs when we use this page table
 		auto page_table = &get_page_table_for(memory_space, pd_index);
@@ -240,12 +326,38 @@ namespace Kernel::Memory::Arch
 		return raw_create_pde(table_addr, is_user, is_writeable, pat_index);
 	}
 
-	static page_table_entry_t create_pte(uintptr_t page_address, page_directory_entry_t &pde, bool is_user, bool is_writeable, uint8_t pat_index)
+	static page_table_entry_t create_pte(uintptr_t page_address, page_directory_entry_t &pde, bool is_user, bool is_writeable, bool is_global, uint8_t pat_index)
 	{
 		// User pages are only allowed in user page directories
 		assert(!is_user || (is_user && pde.user));
+		// User pages differ between paging spaces and as such may never be global
+		assert(!is_user || !is_global);
+
+		return raw_create_pte(page_address, is_user, is_writeable, is_global && s_global_pages, pat_index);
+	}
+
+	static void flush_range(uintptr_t virt_addr, size_t size, bool include_global)
+	{
+		if (size / PAGE_SIZE > TLB_FLUSH_ALL_THRESHOLD)
+		{
+			// Reloading CR3 leaves global pages alone, toggling CR4.PGE flushes them as well
+			if (include_global && s_global_pages)
+			{
+				uintptr_t cr4 = CPU::Processor::cr4();
+				CPU::Processor::set_cr4(cr4 & ~CR4_PGE);
+				CPU::Processor::set_cr4(cr4);
+			}
+			else
+			{
+				CPU::Processor::flush_page_directory();
+			}
+
+			return;
+		}
 
-		return raw_create_pte(page_address, is_user, is_writeable, pat_index);
+		for_page_in_range(virt_addr, size, [](uintptr_t address) {
+			CPU::Processor::invalidate_address(address);
+		});
 	}
 
 	static void for_page_in_range(uintptr_t virt_addr, size_t size, LibK::function<void(uintptr_t)> callback)
@@ -256,6 +368,65 @@ namespace Kernel::Memory::Arch
 			callback(virt_addr);
 	}
 
+	static bool try_map_huge_page(paging_space_t &memory_space, uintptr_t phys_addr, uintptr_t virt_addr, uintptr_t page_limit, mapping_config_t config)
+	{
+		if (virt_addr % PAGE_SIZE_HUGE != 0 || phys_addr % PAGE_SIZE_HUGE != 0 || page_limit - virt_addr < PAGE_SIZE_HUGE)
+			return false;
+
+		size_t pd_index = get_pd_index(virt_addr);
+		auto &page_directory = get_page_directory_for(memory_space);
+
+		bool is_global = is_kernel_space(virt_addr) && !config.userspace && s_global_pages;
+		auto pde = raw_create_huge_pde(phys_addr, config.userspace, config.writeable, is_global, caching_mode_to_pat_index(config.caching_mode));
+
+		if (!is_kernel_space(virt_addr))
+		{
+			// Already covered by a page table with other mappings in it
+			if (page_directory[pd_index].value() != 0)
+				return false;
+
+			page_directory[pd_index] = pde;
+			return true;
+		}
+
+		// NOTE: The range spans the whole table, so nobody else can map into it concurrently
+		s_page_directory_lock.lock();
+
+		bool is_free = !s_master_page_directory->tables[pd_index].page_size && is_page_table_empty(get_page_table_for(memory_space, pd_index));
+		if (is_free)
+			set_kernel_pde(pd_index, pde);
+
+		s_page_directory_lock.unlock();
+
+		// Other cores may still cache the entry of the empty page table. The preallocated table stays around, so nothing has to wait
+		if (is_free)
+			invalidate(memory_space, virt_addr, PAGE_SIZE, false);
+
+		return is_free;
+	}
+
+	static void set_kernel_pde(size_t pd_index, page_directory_entry_t pde)
+	{
+		assert(s_page_directory_lock.is_locked());
+
+		// The mapping tables keep pointing to the preallocated page table, so it can be restored later on
+		s_master_page_directory->tables[pd_index] = pde;
+
+		for (auto *page_directory : s_page_directories)
+			page_directory->tables[pd_index] = pde;
+	}
+
+	static bool is_page_table_empty(page_table_t &page_table)
+	{
+		for (size_t i = 0; i < PAGE_COUNT; i++)
+		{
+			if (page_table[i].value() != 0)
+				return false;
+		}
+
+		return true;
+	}
+
 	static uint8_t caching_mode_to_pat_index(CachingMode mode)
 	{
 		switch (mode)
@@ -280,7 +451,11 @@ namespace Kernel::Memory::Arch
 		uintptr_t pd_index = get_pd_index(virt_addr);
 		uintptr_t pt_index = get_pt_index(virt_addr);
 
-		assert(get_page_directory()[pd_index].present);
+		auto &pde = get_page_directory()[pd_index];
+		assert(pde.present);
+
+		if (pde.page_size)
+			return to_directory_address((uintptr_t)pde.table()) + (virt_addr & ~DIRECTORY_MASK);
 
 		auto &page_table = get_page_table(pd_index);
 		assert(page_table[pt_index].present);
@@ -293,13 +468,24 @@ namespace Kernel::Memory::Arch
 		uintptr_t pd_index = get_pd_index(virt_addr);
 		uintptr_t pt_index = get_pt_index(virt_addr);
 
+		auto &pde = get_page_directory_for(memory_space)[pd_index];
+		assert(pde.present);
+
+		if (pde.page_size)
+			return to_directory_address((uintptr_t)pde.table()) + (virt_addr & ~DIRECTORY_MASK);
+
+		CPU::Processor::current().enter_critical();
+
 		auto &page_table = get_page_table_for(memory_space, pd_index);
 		assert(page_table[pt_index].present);
 		uintptr_t address = (uintptr_t)page_table[pt_index].page() + get_offset(virt_addr);
 
+		CPU::Processor::current().leave_critical();
+
 		return address;
 	}
 
+	// Called on every core as the PAT and CR4 are per core
 	void initialize()
 	{
 		uint64_t pat = 0;
@@ -313,6 +499,20 @@ namespace Kernel::Memory::Arch
 		pat |= (uint64_t)PAT_MODE_UNCACHEABLE << 56;
 
 		write_msr(IA32_PAT_MSR, pat);
+
+		auto features = cpuid(CPUID_LEAF_FEATURES);
+
+		if (features.edx & CPUID_FEATURE_EDX_PGE)
+		{
+			s_global_pages = true;
+			CPU::Processor::set_cr4(CPU::Processor::cr4() | CR4_PGE);
+		}
+
+		if (features.edx & CPUID_FEATURE_EDX_PSE)
+		{
+			s_huge_pages = true;
+			CPU::Processor::set_cr4(CPU::Processor::cr4() | CR4_PSE);
+		}
 	}
 
 	paging_space_t create_kernel_space()
@@ -331,7 +531,7 @@ namespace Kernel::Memory::Arch
 		uintptr_t pd_address = (uintptr_t)&page_directory - (uintptr_t)&_virtual_addr;
 
 		page_directory[PAGE_COUNT - 1] = raw_create_pde(pt_address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
-		mapping_table[PAGE_COUNT - 1] = raw_create_pte(pd_address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+		mapping_table[PAGE_COUNT - 1] = raw_create_pte(pd_address, false, true, false, caching_mode_to_pat_index(CachingMode::Uncacheable));
 
 		// Calculate the amount of pages needed for the kernel and map it
 		uintptr_t p_address = (uintptr_t)&_physical_addr;
@@ -357,7 +557,7 @@ namespace Kernel::Memory::Arch
 				uintptr_t address = (uintptr_t)&page_table - (uintptr_t)&_virtual_addr;
 
 				page_directory[pd_index] = raw_create_pde(address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
-				mapping_table[pd_index] = raw_create_pte(address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+				mapping_table[pd_index] = raw_create_pte(address, false, true, false, caching_mode_to_pat_index(CachingMode::Uncacheable));
 			}
 
 			auto &page_table = *(page_table_t *)((uintptr_t)page_directory[pd_index].table() + (uintptr_t)&_virtual_addr);
@@ -365,7 +565,7 @@ namespace Kernel::Memory::Arch
 			size_t pt_index = get_pt_index(v_address);
 			uintptr_t page_address = to_page_address(p_address);
 
-			page_table[pt_index] = raw_create_pte(page_address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+			page_table[pt_index] = raw_create_pte(page_address, false, true, s_global_pages, caching_mode_to_pat_index(CachingMode::Uncacheable));
 		}
 
 		auto *page_table_ptr = (page_table_t *)kcalloc(PAGE_SIZE, PAGE_SIZE);
@@ -375,24 +575,41 @@ namespace Kernel::Memory::Arch
 
 		uintptr_t address = (uintptr_t)&page_table - (uintptr_t)&_virtual_addr;
 
-		constexpr uintptr_t map_pd_index = get_pd_index(FIXED_PAGE_TABLE_MAP_ADDR);
+		constexpr uintptr_t map_pd_index = get_pd_index(FIXED_MAPPING_ADDR);
 		page_directory[map_pd_index] = raw_create_pde(address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
-		mapping_table[map_pd_index] = raw_create_pte(address, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+		mapping_table[map_pd_index] = raw_create_pte(address, false, true, false, caching_mode_to_pat_index(CachingMode::Uncacheable));
 
 		s_kernel_paging_space = paging_space_t{
 		    .physical_pd_address = pd_address,
 		    .page_directory = &page_directory,
 		    .mapping_table = &mapping_table,
-		    .page_directory_version = 0,
+		    .active_cores = nullptr,
 		};
 
 		s_master_page_directory = page_directory_ptr;
 		s_master_mapping_table = mapping_table_ptr;
-		s_page_directory_version = 0;
 
 		return s_kernel_paging_space;
 	}
 
+	void preallocate_kernel_page_tables()
+	{
+		size_t kernel_start_pd_index = get_pd_index((uintptr_t)&_virtual_addr);
+		constexpr size_t map_pd_index = get_pd_index(FIXED_MAPPING_ADDR);
+
+		assert(CPU::Processor::get_page_directory() == s_kernel_paging_space.physical_pd_address);
+
+		CPU::Processor::current().enter_critical();
+
+		for (size_t pd_index = kernel_start_pd_index; pd_index < map_pd_index; pd_index++)
+		{
+			if (s_master_page_directory->tables[pd_index].value() == 0)
+				s_master_page_directory->tables[pd_index] = create_pde(pd_index, s_kernel_paging_space, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
+		}
+
+		CPU::Processor::current().leave_critical();
+	}
+
 	// Create a new empty memory space where only kernel space is mapped and userspace is empty
 	paging_space_t create_memory_space()
 	{
@@ -417,7 +634,7 @@ namespace Kernel::Memory::Arch
 		void *mp_dest = &mapping_table[kernel_start_pd_index];
 		memcpy(mp_dest, mp_src, byte_size);
 
-		uint64_t version = s_page_directory_version;
+		s_page_directories.push_back(page_directory_ptr);
 		s_page_directory_lock.unlock();
 
 		page_directory[PAGE_COUNT - 1].page_table_address = as_physical((uintptr_t)mapping_table_ptr) >> 12;
@@ -427,7 +644,7 @@ namespace Kernel::Memory::Arch
 		    .physical_pd_address = as_physical((uintptr_t)page_directory_ptr),
 		    .page_directory = &page_directory,
 		    .mapping_table = &mapping_table,
-		    .page_directory_version = version,
+		    .active_cores = new std::atomic<uint32_t>(0),
 		};
 	}
 
@@ -436,106 +653,298 @@ namespace Kernel::Memory::Arch
 		assert(virt_addr + size < PAGE_TABLE_ARRAY_ADDR);
 
 		uint8_t pat_index = caching_mode_to_pat_index(config.caching_mode);
+		bool is_global = is_kernel_space(virt_addr) && !config.userspace;
 
 		auto &page_directory = get_page_directory_for(memory_space);
 
-		for_page_in_range(virt_addr, size, [&](uintptr_t virt_addr) {
+		CPU::Processor::current().enter_critical();
+
+		uintptr_t page_limit = LibK::round_up_to_multiple<uintptr_t>(virt_addr + size, PAGE_SIZE);
+
+		while (virt_addr < page_limit)
+		{
+			if (config.huge_pages && s_huge_pages && try_map_huge_page(memory_space, phys_addr, virt_addr, page_limit, config))
+			{
+				virt_addr += PAGE_SIZE_HUGE;
+				phys_addr += PAGE_SIZE_HUGE;
+				continue;
+			}
+
 			size_t pd_index = get_pd_index(virt_addr);
 			size_t pt_index = get_pt_index(virt_addr);
 
 			if (page_directory[pd_index].value() == 0)
 			{
-				if (is_kernel_space(virt_addr))
-				{
-					s_page_directory_lock.lock();
-					if (s_master_page_directory->tables[pd_index].value() == 0)
-					{
-						s_master_page_directory->tables[pd_index] = create_pde(pd_index, memory_space, config.userspace, config.writeable, caching_mode_to_pat_index(CachingMode::Uncacheable));
-						s_master_mapping_table->pages[pd_index] = raw_create_pte(s_master_page_directory->tables[pd_index].page_table_address << 12, false, true, caching_mode_to_pat_index(CachingMode::Uncacheable));
-						s_page_directory_version++;
-						auto &processor = CPU::Processor::current();
-						processor.get_memory_space()->paging_space.page_directory_version = s_page_directory_version;
-						processor.smp_broadcast(LibK::make_shared<DirectoryInvalidatedMessage>(), true);
-					}
-					page_directory[pd_index] = s_master_page_directory->tables[pd_index];
-					s_page_directory_lock.unlock();
-				}
-				else
-				{
-					page_directory[pd_index] = create_pde(pd_index, memory_space, config.userspace, config.writeable, pat_index);
-				}
+				// Kernel page tables are preallocated
+				assert(!is_kernel_space(virt_addr));
+				// The table may hold read-only and writeable pages, as such the write permission is left to each page
+				page_directory[pd_index] = create_pde(pd_index, memory_space, config.userspace, true, pat_index);
 			}
 
 			assert(page_directory[pd_index].present);
+			assert(!page_directory[pd_index].page_size);
 
 			auto &page_table = get_page_table_for(memory_space, pd_index);
 
 			assert(!page_table[pt_index].present);
 
 			uintptr_t page_address = to_page_address(phys_addr);
+
+			page_table[pt_index] = create_pte(page_address, page_directory[pd_index], config.userspace, config.writeable, is_global, pat_index);
+
+			virt_addr += PAGE_SIZE;
 			phys_addr += PAGE_SIZE;
+		}
 
-			page_table[pt_index] = create_pte(page_address, page_directory[pd_index], config.userspace, config.writeable, pat_index);
+		// NOTE: Not-present entries are never cached by the TLB, so mapping fresh pages needs no shootdown
 
-			invalidate(virt_addr);
-		});
+		CPU::Processor::current().leave_critical();
 	}
 
-	void unmap(__unused paging_space_t &memory_space, uintptr_t virt_addr, size_t size)
+	void unmap(paging_space_t &memory_space, uintptr_t virt_addr, size_t size)
+	{
+		unmap_range(memory_space, virt_addr, size, false, [](uintptr_t) {}, [](size_t) {});
+	}
+
+	void unmap_sparse(paging_space_t &memory_space, uintptr_t virt_addr, size_t size, const LibK::function<void(uintptr_t)> &callback, const LibK::function<void(size_t)> &swap_callback)
+	{
+		unmap_range(memory_space, virt_addr, size, true, callback, swap_callback);
+	}
+
+	static void unmap_range(paging_space_t &memory_space, uintptr_t virt_addr, size_t size, bool is_sparse, const LibK::function<void(uintptr_t)> &callback, const LibK::function<void(size_t)> &swap_callback)
 	{
 		assert(virt_addr + size < PAGE_TABLE_ARRAY_ADDR);
 
 		LibK::vector<size_t> page_tables_to_check = LibK::vector<size_t>();
 		size_t current = PAGE_COUNT;
 
+		// Other cores may write through stale entries until they acknowledged the shootdown, so frames and page tables
+		// are only handed back once that happened
+		LibK::vector<region_t> frames_to_free = LibK::vector<region_t>();
+		LibK::vector<uintptr_t> page_tables_to_free = LibK::vector<uintptr_t>();
+
+		auto defer_free = [&frames_to_free](uintptr_t phys_addr, size_t size) {
+			if (!frames_to_free.empty() && frames_to_free.back().end() + 1 == phys_addr)
+				frames_to_free.back().size += size;
+			else
+				frames_to_free.push_back({phys_addr, size});
+		};
+
 		auto &page_directory = get_page_directory_for(memory_space);
 
-		for_page_in_range(virt_addr, size, [&](uintptr_t virt_addr) {
-			static const page_table_entry_t null_pt_entry{};
+		static const page_table_entry_t null_pt_entry{};
+		static const page_directory_entry_t null_pd_entry{};
+
+		CPU::Processor::current().enter_critical();
+
+		uintptr_t address = virt_addr;
+		uintptr_t page_limit = LibK::round_up_to_multiple<uintptr_t>(virt_addr + size, PAGE_SIZE);
+
+		while (address < page_limit)
+		{
+			size_t pd_index = get_pd_index(address);
+
+			if (is_sparse && !page_directory[pd_index].present)
+			{
+				address = LibK::round_down_to_multiple<uintptr_t>(address, PAGE_SIZE_HUGE) + PAGE_SIZE_HUGE;
+				continue;
+			}
 
-			size_t pd_index = get_pd_index(virt_addr);
 			assert(page_directory[pd_index].present);
 
-			size_t pt_index = get_pt_index(virt_addr);
+			if (page_directory[pd_index].page_size)
+			{
+				// Huge pages are only created for ranges that span them completely
+				assert(address % PAGE_SIZE_HUGE == 0 && page_limit - address >= PAGE_SIZE_HUGE);
+
+				uintptr_t phys_addr = to_directory_address((uintptr_t)page_directory[pd_index].table());
+
+				if (is_kernel_space(address))
+				{
+					// Put back the preallocated page table
+					s_page_directory_lock.lock();
+					set_kernel_pde(pd_index, raw_create_pde((uintptr_t)s_master_mapping_table->pages[pd_index].page(), false, true, caching_mode_to_pat_index(CachingMode::Uncacheable)));
+					s_page_directory_lock.unlock();
+				}
+				else
+				{
+					page_directory[pd_index] = null_pd_entry;
+				}
+
+				defer_free(phys_addr, PAGE_SIZE_HUGE);
+
+				address += PAGE_SIZE_HUGE;
+				continue;
+			}
+
+			size_t pt_index = get_pt_index(address);
 			auto &page_table = get_page_table_for(memory_space, pd_index);
-			assert(page_table[pt_index].present);
 
-			page_table[pt_index] = null_pt_entry;
+			auto &entry = page_table[pt_index];
+
+			if (is_sparse && !entry.present && !entry.swapped)
+			{
+				address += PAGE_SIZE;
+				continue;
+			}
+
+			if (entry.swapped)
+			{
+				size_t slot = entry.page_address;
+				entry = null_pt_entry;
+				swap_callback(slot);
+			}
+			else
+			{
+				assert(entry.present);
+
+				uintptr_t phys_addr = (uintptr_t)entry.page();
+				entry = null_pt_entry;
+				defer_free(phys_addr, PAGE_SIZE);
+			}
 
-			// TODO: Implement deletion of kernel space page directories
-			if (current != pd_index && !is_kernel_space(virt_addr))
+			// Kernel page tables are shared by every paging space and as such never freed
+			if (current != pd_index && !is_kernel_space(address))
 			{
 				page_tables_to_check.push_back(pd_index);
 				current = pd_index;
 			}
 
-			invalidate(virt_addr);
-		});
-
-		static const page_directory_entry_t null_pd_entry{};
+			address += PAGE_SIZE;
+		}
 
 		// Check if page directories have become empty
 		for (auto pd_index : page_tables_to_check)
 		{
-			auto &page_table = get_page_table_for(memory_space, pd_index);
-			bool to_delete = true;
-
-			for (size_t i = 0; i < PAGE_COUNT; i++)
-			{
-				if (page_table[i].value() != 0)
-				{
-					to_delete = false;
-					break;
-				}
-			}
-
-			if (to_delete)
+			if (is_page_table_empty(get_page_table_for(memory_space, pd_index)))
 			{
-				void *phys_addr = (void *)page_directory[pd_index].table();
+				page_tables_to_free.push_back((uintptr_t)page_directory[pd_index].table());
 				page_directory[pd_index] = null_pd_entry;
-				PhysicalMemoryManager::instance().free(phys_addr, PAGE_SIZE);
 			}
 		}
+
+		invalidate(memory_space, virt_addr, size);
+
+		CPU::Processor::current().leave_critical();
+
+		for (auto phys_addr : page_tables_to_free)
+			PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(phys_addr), PAGE_SIZE);
+
+		for (auto frames : frames_to_free)
+		{
+			for (size_t offset = 0; offset < frames.size; offset += PAGE_SIZE)
+				callback(frames.address + offset);
+		}
+	}
+
+	bool is_mapped(paging_space_t &memory_space, uintptr_t virt_addr)
+	{
+		size_t pd_index = get_pd_index(virt_addr);
+		size_t pt_index = get_pt_index(virt_addr);
+
+		auto &pde = get_page_directory_for(memory_space)[pd_index];
+
+		if (!pde.present || pde.page_size)
+			return pde.present;
+
+		CPU::Processor::current().enter_critical();
+		bool present = get_page_table_for(memory_space, pd_index)[pt_index].present;
+		CPU::Processor::current().leave_critical();
+
+		return present;
+	}
+
+	void zero_page(uintptr_t phys_addr)
+	{
+		CPU::Processor::current().enter_critical();
+		memset(map_fixed_data_page(phys_addr), 0, PAGE_SIZE);
+		CPU::Processor::current().leave_critical();
+	}
+
+	void copy_page(uintptr_t phys_addr, const void *source)
+	{
+		CPU::Processor::current().enter_critical();
+		memcpy(map_fixed_data_page(phys_addr), source, PAGE_SIZE);
+		CPU::Processor::current().leave_critical();
+	}
+
+	void copy_from_page(void *destination, uintptr_t phys_addr)
+	{
+		CPU::Processor::current().enter_critical();
+		memcpy(destination, map_fixed_data_page(phys_addr), PAGE_SIZE);
+		CPU::Processor::current().leave_critical();
+	}
+
+	static page_table_entry_t *get_pte(paging_space_t &memory_space, uintptr_t virt_addr)
+	{
+		auto &pde = get_page_directory_for(memory_space)[get_pd_index(virt_addr)];
+
+		// Huge pages have no page table entry of their own
+		if (!pde.present || pde.page_size)
+			return nullptr;
+
+		auto &page_table = get_page_table_for(memory_space, get_pd_index(virt_addr));
+		return &page_table[get_pt_index(virt_addr)];
+	}
+
+	bool test_and_clear_accessed(paging_space_t &memory_space, uintptr_t virt_addr)
+	{
+		CPU::Processor::current().enter_critical();
+
+		auto *entry = get_pte(memory_space, virt_addr);
+		assert(entry && entry->present);
+
+		bool accessed = entry->accessed;
+		entry->accessed = false;
+
+		// The CPU only sets the flag again once the entry has left the TLB. Other cores are not bothered with a shootdown,
+		// as such a page that stays cached there is merely considered cold a bit earlier.
+		if (accessed && CPU::Processor::get_page_directory() == memory_space.physical_pd_address)
+			CPU::Processor::invalidate_address(virt_addr);
+
+		CPU::Processor::current().leave_critical();
+
+		return accessed;
+	}
+
+	uintptr_t set_swap_entry(paging_space_t &memory_space, uintptr_t virt_addr, size_t slot)
+	{
+		assert(!is_kernel_space(virt_addr));
+		assert(slot < SWAP_SLOT_LIMIT);
+
+		CPU::Processor::current().enter_critical();
+
+		auto *entry = get_pte(memory_space, virt_addr);
+		assert(entry && entry->present);
+
+		uintptr_t phys_addr = (uintptr_t)entry->page();
+
+		page_table_entry_t swap_entry{};
+		swap_entry.swapped = true;
+		swap_entry.page_address = slot;
+		*entry = swap_entry;
+
+		// The caller reads the frame and frees it next, so no core may still write to it through a stale entry
+		invalidate(memory_space, virt_addr, PAGE_SIZE);
+
+		CPU::Processor::current().leave_critical();
+
+		return phys_addr;
+	}
+
+	bool get_swap_entry(paging_space_t &memory_space, uintptr_t virt_addr, size_t &slot)
+	{
+		CPU::Processor::current().enter_critical();
+
+		auto *entry = get_pte(memory_space, virt_addr);
+		bool swapped = entry && entry->swapped;
+
+		if (swapped)
+			slot = entry->page_address;
+
+		CPU::Processor::current().leave_critical();
+
+		return swapped;
 	}
 
 	memory_region_t get_kernel_region()
@@ -562,10 +971,11 @@ namespace Kernel::Memory::Arch
 
 	memory_region_t get_mapping_region()
 	{
+		// Covers the fixed mapping windows as well as the page table array
 		return memory_region_t{
-		    .virt_address = PAGE_TABLE_ARRAY_ADDR,
+		    .virt_address = FIXED_MAPPING_ADDR,
 		    .phys_address = 0, // does not apply here
-		    .size = TABLE_SIZE,
+		    .size = 2 * TABLE_SIZE,
 		    .mapped = true,
 		    .present = true,
 		    .allocated = true,
@@ -581,37 +991,67 @@ namespace Kernel::Memory::Arch
 		CPU::Processor::load_page_directory(memory_space.physical_pd_address);
 	}
 
-	void invalidate(uintptr_t virtual_address)
+	void invalidate(paging_space_t &memory_space, uintptr_t virt_addr, size_t size, bool wait)
 	{
-		CPU::Processor::invalidate_address(virtual_address);
-		if (is_kernel_space(virtual_address))
-			CPU::Processor::current().smp_broadcast(LibK::make_shared<PageInvalidatedMessage>(virtual_address), true);
+		auto &current = CPU::Processor::current();
+		bool is_kernel = is_kernel_space(virt_addr);
+
+		if (is_kernel || CPU::Processor::get_page_directory() == memory_space.physical_pd_address)
+			flush_range(virt_addr, size, is_kernel);
+
+		if (CPU::Processor::count() == 1)
+			return;
+
+		// The PTE store must be visible before the mask is read, otherwise a core that loads the space in between
+		// could miss both the new entry and the shootdown. Its fetch_or is the matching barrier on the other side
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// Only cores that have the paging space loaded can hold stale entries of userland addresses
+		uintptr_t physical_pd_address = is_kernel ? 0 : memory_space.physical_pd_address;
+		uint32_t active_cores = is_kernel || !memory_space.active_cores ? UINT32_MAX : memory_space.active_cores->load();
+		bool is_sent = false;
+
+		// Other cores spinning on a lock this core holds handle the message while they wait, see Processor::relax()
+		current.enter_critical();
+
+		auto &message = s_shootdown_messages.local();
+		assert(message);
+
+		// A previous shootdown that did not wait may still be in flight
+		while (!message->is_acknowledged())
+			CPU::Processor::relax();
+
+		message->prepare(physical_pd_address, virt_addr, size);
+
+		CPU::Processor::enumerate([&](CPU::Processor &processor) {
+			if (&processor == &current)
+				return true;
+
+			if (processor.id() < ACTIVE_CORE_LIMIT && !(active_cores & (1u << processor.id())))
+				return true;
+
+			// Counted before it is sent, so the acknowledgements can never reach zero early
+			message->add_recipient();
+			processor.smp_enqueue_message(message);
+			processor.smp_poke();
+			is_sent = true;
+
+			return true;
+		});
+
+		while (wait && is_sent && !message->is_acknowledged())
+			CPU::Processor::relax();
+
+		current.leave_critical();
 	}
 
-	Arch::paging_space_t get_kernel_paging_space()
+	void initialize_shootdowns()
 	{
-		return s_kernel_paging_space;
+		s_shootdown_messages.local() = LibK::make_shared<TLBShootdownMessage>();
 	}
 
-	// TODO: Upgrade to using journaling
-	void check_page_directory()
+	Arch::paging_space_t get_kernel_paging_space()
 	{
-		// NOTE: This is a critical section as getting preempted inside this operation can cause the data of the page directory loaded
-		//       to not correspond to the version code loaded later.
-		s_page_directory_lock.lock();
-		paging_space_t &paging_space = CPU::Processor::current().get_memory_space()->paging_space;
-
-		if (paging_space.page_directory_version != s_page_directory_version)
-		{
-			size_t pd_index = get_pd_index(reinterpret_cast<uintptr_t>(&_virtual_addr));
-			size_t count = (PAGE_COUNT - pd_index - 1) * sizeof(page_directory_entry_t);
-			memcpy(&get_page_directory().tables[pd_index], &s_master_page_directory->tables[pd_index], count);
-			memcpy(&paging_space.mapping_table->pages[pd_index], &s_master_mapping_table->pages[pd_index], count);
-			CPU::Processor::load_page_directory(paging_space.physical_pd_address);
-			log("MEMORY", "Updated kernel page directory");
-		}
-
-		paging_space.page_directory_version = s_page_directory_version;
-		s_page_directory_lock.unlock();
+		return s_kernel_paging_space;
 	}
 } // namespace Kernel::Memory::Arch
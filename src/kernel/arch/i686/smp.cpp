@@ -32,7 +32,7 @@ namespace Kernel::CPU
 	void prepare_smp_boot_environment()
 	{
 		// Reserve memory space for boot code
-		Memory::PhysicalMemoryManager::instance().alloc(ap_boot_code_size, boot_address);
+		Memory::PhysicalMemoryManager::instance().reserve(boot_address, ap_boot_code_size);
 		auto region = Memory::VirtualMemoryManager::instance().map_region_identity(boot_address, ap_boot_code_size);
 		assert(region.mapped);
 
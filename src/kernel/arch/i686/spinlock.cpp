@@ -21,7 +21,7 @@ namespace Kernel::Locking
 		while (m_lock.test_and_set(std::memory_order_acquire))
 		{
 			while (m_lock.test(std::memory_order_relaxed))
-				CPU::Processor::pause();
+				CPU::Processor::relax();
 		}
 	}
 
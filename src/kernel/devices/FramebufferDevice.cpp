@@ -25,6 +25,7 @@ namespace Kernel
 		config.writeable = true;
 		config.readable = true;
 		config.userspace = false;
+		config.huge_pages = true;
 		auto region = Memory::VirtualMemoryManager::instance().map_region(multiboot_info->framebuffer_addr, m_size, config);
 		m_framebuffer = (uint8_t *)region.virt_region().pointer();
 
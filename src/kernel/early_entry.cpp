@@ -72,6 +72,9 @@ namespace Kernel
 			auto end = (uintptr_t)&_kernel_end;
 			uintptr_t size = end - start;
 
+			// Locks and the heap already need to know the executing core
+			CPU::Processor::install_boot_gdt();
+
 			assert(size <= 0x700000);
 			assert(magic == MULTIBOOT_BOOTLOADER_MAGIC);
 			assert(multiboot_info);
@@ -6,19 +6,46 @@
 #include "filesystem/File.hpp"
 #include <arch/Processor.hpp>
 #include <filesystem/VirtualFileSystem.hpp>
+#include <locking/Mutex.hpp>
+#include <memory/ShrinkerRegistry.hpp>
 #include <tty/VirtualConsole.hpp>
 
 namespace Kernel::ELF
 {
-	static void *s_loader_image_address = nullptr;
-	static File *s_loader_file = nullptr;
-	static size_t s_loader_image_size = 0;
-	static size_t s_loader_entry_offset = 0;
+	// Page aligned part of a cached image that gets mapped into each process
+	typedef struct image_segment_t
+	{
+		uintptr_t offset;
+		size_t size;
+		bool writeable;
+	} image_segment_t;
+
+	// PT_LOAD segments of an executable laid out as in memory, every process running the same file maps these pages
+	typedef struct image_t
+	{
+		size_t inode_number;
+		size_t file_size;
+		size_t file_generation;
+		uintptr_t base;
+		uintptr_t entry;
+		bool is_dynamic;
+		Memory::memory_region_t region;
+		LibK::vector<image_segment_t> segments;
+		size_t refcount;
+	} image_t;
+
+	static Locking::Mutex s_image_cache_lock;
+	static LibK::vector<image_t *> s_images{};
+	static image_t *s_loader_image = nullptr;
 
 	static bool hasSignature(elf32_ehdr_t *header);
 	static void set_up_stack(const char **argv, const char **envp, const char *filename, void *exec_base, void *entry, void *loader_base, thread_t *thread);
-	static void load_dynamic_loader_image();
-	static uintptr_t map_dynamic_loader();
+	static image_t *create_image(File *file);
+	static void destroy_image(image_t *image);
+	static image_t *acquire_image(File *file);
+	static image_t *acquire_loader_image();
+	static void map_image(image_t *image, uintptr_t offset);
+	static size_t shrink(size_t page_count);
 
 	static bool hasSignature(elf32_ehdr_t *header)
 	{
@@ -85,78 +112,245 @@ namespace Kernel::ELF
 		CPU::Processor::thread_push_userspace_data(thread, (int)args.size());
 	}
 
-	static void load_dynamic_loader_image()
+	static image_t *create_image(File *file)
 	{
-		if (s_loader_image_address)
-			return;
+		// Taken before reading, so a write that races with the read makes the image stale rather than current
+		size_t generation = file->generation();
 
-		s_loader_file = VirtualFileSystem::instance().find_by_path("/lib/ld-owos.so");
-		auto region = Memory::VirtualMemoryManager::instance().allocate_region(s_loader_file->size());
-		s_loader_file->read(0, s_loader_file->size(), reinterpret_cast<char *>(region.virt_address));
+		auto region = Memory::VirtualMemoryManager::instance().allocate_region(file->size());
+		file->read(0, file->size(), reinterpret_cast<char *>(region.virt_address));
 		auto header = static_cast<elf32_ehdr_t *>((void *)region.virt_address);
 
 		assert(hasSignature(header)); // TODO: Error handling
 
+		uintptr_t start = UINTPTR_MAX;
+		uintptr_t end = 0;
+
 		for (int i = 0; i < header->e_phnum; i++)
 		{
 			auto *pheader = (elf32_phdr_t *)(region.virt_address + header->e_phoff + header->e_phentsize * i);
 			if (pheader->p_type == PT_LOAD)
 			{
-				s_loader_image_size = LibK::max<size_t>(s_loader_image_size, pheader->p_vaddr + pheader->p_memsz);
+				start = LibK::min<uintptr_t>(start, LibK::round_down_to_multiple<uintptr_t>(pheader->p_vaddr, PAGE_SIZE));
+				end = LibK::max<uintptr_t>(end, pheader->p_vaddr + pheader->p_memsz);
 			}
 		}
 
-		s_loader_entry_offset = header->e_entry;
+		assert(start < end);
+
+		auto *image = new image_t{
+		    .inode_number = file->inode_number(),
+		    .file_size = file->size(),
+		    .file_generation = generation,
+		    .base = start,
+		    .entry = header->e_entry,
+		    .is_dynamic = header->e_type == ET_DYN || header->e_type == ET_REL,
+		    .region = Memory::VirtualMemoryManager::instance().allocate_region(end - start),
+		    .segments = {},
+		    .refcount = 1,
+		};
 
-		auto image_region = Memory::VirtualMemoryManager::instance().allocate_region(s_loader_image_size);
-		s_loader_image_address = image_region.virt_region().pointer();
-		assert(s_loader_image_address);
+		auto image_address = image->region.virt_address;
+		assert(image_address);
+		memset((void *)image_address, 0, image->region.size);
 
 		for (int i = 0; i < header->e_phnum; i++)
 		{
 			auto *pheader = (elf32_phdr_t *)(region.virt_address + header->e_phoff + header->e_phentsize * i);
 			if (pheader->p_type == PT_LOAD)
 			{
-				memcpy((void *)(image_region.virt_address + pheader->p_vaddr), (void *)(region.virt_address + pheader->p_offset), pheader->p_filesz);
-				memset((void *)(image_region.virt_address + pheader->p_vaddr + pheader->p_filesz), 0, pheader->p_memsz - pheader->p_filesz);
+				memcpy((void *)(image_address + pheader->p_vaddr - start), (void *)(region.virt_address + pheader->p_offset), pheader->p_filesz);
+
+				uintptr_t segment_start = LibK::round_down_to_multiple<uintptr_t>(pheader->p_vaddr, PAGE_SIZE) - start;
+				uintptr_t segment_end = LibK::round_up_to_multiple<uintptr_t>(pheader->p_vaddr + pheader->p_memsz, PAGE_SIZE) - start;
+				bool writeable = pheader->p_flags & PF_W;
+
+				// Segments that share a page get merged, PT_LOAD entries are sorted by their address
+				if (!image->segments.empty() && image->segments.back().offset + image->segments.back().size > segment_start)
+				{
+					auto &last = image->segments.back();
+					last.size = LibK::max(last.offset + last.size, segment_end) - last.offset;
+					last.writeable |= writeable;
+					continue;
+				}
+
+				image->segments.push_back({.offset = segment_start, .size = segment_end - segment_start, .writeable = writeable});
+			}
+		}
+
+		Memory::VirtualMemoryManager::instance().free(region);
+
+		return image;
+	}
+
+	static void destroy_image(image_t *image)
+	{
+		Memory::VirtualMemoryManager::instance().free(image->region);
+		delete image;
+	}
+
+	static image_t *acquire_image(File *file)
+	{
+		auto find_cached = [file]() -> image_t * {
+			// Files without an inode can not be told apart, they never share an image
+			if (file->inode_number() == 0)
+				return nullptr;
+
+			// Images of rewritten files stay until the shrinker drops them, they are never matched again
+			for (auto *image : s_images)
+			{
+				if (image->inode_number == file->inode_number() && image->file_size == file->size() && image->file_generation == file->generation())
+				{
+					image->refcount++;
+					return image;
+				}
+			}
+
+			return nullptr;
+		};
+
+		s_image_cache_lock.lock();
+		image_t *image = find_cached();
+		s_image_cache_lock.unlock();
+
+		if (image)
+			return image;
+
+		// Reading the file may block, so the cache is not locked in the meantime
+		image = create_image(file);
+
+		s_image_cache_lock.lock();
+
+		if (auto *cached = find_cached())
+		{
+			s_image_cache_lock.unlock();
+			destroy_image(image);
+			return cached;
+		}
+
+		s_images.push_back(image);
+		s_image_cache_lock.unlock();
+
+		return image;
+	}
+
+	static image_t *acquire_loader_image()
+	{
+		s_image_cache_lock.lock();
+		image_t *image = s_loader_image;
+		if (image)
+			image->refcount++;
+		s_image_cache_lock.unlock();
+
+		if (image)
+			return image;
+
+		File *file = VirtualFileSystem::instance().find_by_path("/lib/ld-owos.so");
+		if (!file)
+			return nullptr;
+
+		// Concurrent callers end up with the same image, as the cache tells them apart by their inode
+		image = acquire_image(file);
+
+		s_image_cache_lock.lock();
+		s_loader_image = image;
+		s_image_cache_lock.unlock();
+
+		return image;
+	}
+
+	static void map_image(image_t *image, uintptr_t offset)
+	{
+		// Read-only segments map the cached pages directly, writeable segments get private copies of the pages that are written to
+		for (auto &segment : image->segments)
+		{
+			auto mapping_conf = Memory::mapping_config_t();
+			mapping_conf.userspace = true;
+			mapping_conf.writeable = segment.writeable;
+
+			auto region = Memory::VirtualMemoryManager::instance().share_region_at(image->region.phys_address + segment.offset, offset + image->base + segment.offset, segment.size, mapping_conf);
+			assert(region.mapped);
+		}
+	}
+
+	static size_t shrink(size_t page_count)
+	{
+		// The allocation may come from within the cache itself, a contended cache is skipped instead of waited for
+		if (!s_image_cache_lock.try_lock())
+			return 0;
+
+		size_t freed = 0;
+
+		// Images without references are not mapped anywhere anymore
+		for (size_t i = 0; i < s_images.size() && freed < page_count;)
+		{
+			image_t *image = s_images[i];
+
+			if (image->refcount > 0)
+			{
+				i++;
+				continue;
 			}
+
+			s_images[i] = s_images.back();
+			s_images.pop_back();
+
+			if (image == s_loader_image)
+				s_loader_image = nullptr;
+
+			freed += image->region.size / PAGE_SIZE;
+			destroy_image(image);
 		}
+
+		s_image_cache_lock.unlock();
+
+		return freed;
+	}
+
+	void initialize()
+	{
+		Memory::ShrinkerRegistry::instance().register_shrinker([](size_t page_count) {
+			return shrink(page_count);
+		});
 	}
 
-	static uintptr_t map_dynamic_loader()
+	void retain_image(image_t *image)
 	{
-		assert(s_loader_image_address);
-
-		uintptr_t offset = 0x88888000; // TODO: ASLR
-		auto mapping_conf = Memory::mapping_config_t();
-		mapping_conf.userspace = true;
-		auto region = Memory::VirtualMemoryManager::instance().allocate_region_at(offset, s_loader_image_size, mapping_conf);
-		assert(region.present);
-		memcpy((void *)offset, s_loader_image_address, s_loader_image_size);
-		return offset;
+		s_image_cache_lock.lock();
+		image->refcount++;
+		s_image_cache_lock.unlock();
+	}
+
+	void release_image(image_t *image)
+	{
+		s_image_cache_lock.lock();
+		assert(image->refcount > 0);
+		image->refcount--;
+		s_image_cache_lock.unlock();
 	}
 
 	thread_t *load(Process *parent_process, File *file, const char **argv, const char **envp, bool is_exec_syscall)
 	{
-		auto region = Memory::VirtualMemoryManager::instance().allocate_region(file->size());
-		file->read(0, file->size(), reinterpret_cast<char *>(region.virt_address));
-		auto header = static_cast<elf32_ehdr_t *>((void *)region.virt_address);
+		image_t *image = acquire_image(file);
 
-		assert(hasSignature(header)); // TODO: Error handling
+		image_t *loader_image = nullptr;
 
-		uintptr_t entry = header->e_entry;
+		uintptr_t entry = image->entry;
 		uintptr_t offset = 0;
 
-		bool is_dynamic = header->e_type == ET_DYN || header->e_type == ET_REL;
-
-		if (is_dynamic)
+		if (image->is_dynamic)
 		{
 			offset = 0x55555000; // TODO: ASLR
 
-			load_dynamic_loader_image();
-			assert(s_loader_image_address);
+			// Every process running a dynamic executable references the loader, so it can be reclaimed once none does
+			loader_image = acquire_loader_image();
+			if (!loader_image)
+			{
+				release_image(image);
+				return nullptr;
+			}
 
-			entry = 0x88888000 + s_loader_entry_offset; // Ehh
+			entry = 0x88888000 + loader_image->entry; // Ehh
 		}
 
 		auto old_memory_space = CPU::Processor::current().get_memory_space();
@@ -164,35 +358,26 @@ namespace Kernel::ELF
 		CPU::Processor::current().enter_critical();
 		Memory::VirtualMemoryManager::load_memory_space(&memory_space);
 
-		for (int i = 0; i < header->e_phnum; i++)
-		{
-			auto *pheader = (elf32_phdr_t *)(region.virt_address + header->e_phoff + header->e_phentsize * i);
-			if (pheader->p_type == PT_LOAD)
-			{
-				// NOTE: This assumes page aligned PT_LOAD entries
-				auto mapping_conf = Memory::mapping_config_t();
-				mapping_conf.userspace = true;
-				//mapping_conf.writeable = pheader->p_flags & PF_W;
-				//mapping_conf.readable = pheader->p_flags & PF_R;
-				auto phys_region = Memory::VirtualMemoryManager::instance().allocate_region_at(offset + pheader->p_vaddr - pheader->p_offset % pheader->p_align, pheader->p_memsz + pheader->p_offset % pheader->p_align, mapping_conf);
-				memcpy((void *)(phys_region.virt_address + pheader->p_offset % pheader->p_align), (void *)(region.virt_address + pheader->p_offset), pheader->p_filesz);
-				memset((void *)(phys_region.virt_address + pheader->p_offset % pheader->p_align + pheader->p_filesz), 0, pheader->p_memsz - pheader->p_filesz);
-			}
-		}
+		map_image(image, offset);
 
 		uintptr_t loader_base = 0;
 
-		if (is_dynamic)
-			loader_base = map_dynamic_loader();
+		if (image->is_dynamic)
+		{
+			loader_base = 0x88888000; // TODO: ASLR
+			map_image(loader_image, loader_base);
+		}
 
 		thread_t *thread = parent_process->get_thread_by_index(0);
 		CPU::Processor::initialize_userspace_thread(thread, entry, parent_process->get_memory_space());
 
-		set_up_stack(argv, envp, file->name().c_str(), reinterpret_cast<void *>(offset), reinterpret_cast<void *>(offset + header->e_entry), reinterpret_cast<void *>(loader_base), thread);
+		set_up_stack(argv, envp, file->name().c_str(), reinterpret_cast<void *>(offset), reinterpret_cast<void *>(offset + image->entry), reinterpret_cast<void *>(loader_base), thread);
 
 		Memory::VirtualMemoryManager::load_memory_space(old_memory_space);
 		CPU::Processor::current().leave_critical();
 
+		parent_process->set_executable_image(image, loader_image);
+
 		if (!is_exec_syscall)
 			parent_process->start_thread(0);
 
@@ -4,12 +4,14 @@
 #include <common_attributes.h>
 #include <devices/FramebufferDevice.hpp>
 #include <elf/elf.hpp>
+#include <filesystem/FileSystemCache.hpp>
 #include <filesystem/VirtualFileSystem.hpp>
 #include <firmware/acpi/Parser.hpp>
 #include <interrupts/InterruptManager.hpp>
 #include <interrupts/LAPIC.hpp>
 #include <locking/Mutex.hpp>
 #include <logging/logger.hpp>
+#include <memory/SwapManager.hpp>
 #include <memory/VirtualMemoryManager.hpp>
 #include <pci/pci.hpp>
 #include <processes/CoreScheduler.hpp>
@@ -17,8 +19,10 @@
 #include <storage/ata/AHCIManager.hpp>
 #include <syscall/SyscallDispatcher.hpp>
 #include <tests.hpp>
+#include <time/Clock.hpp>
 #include <time/EventManager.hpp>
 #include <time/PIT.hpp>
+#include <time/TimePage.hpp>
 #include <tty/VirtualConsole.hpp>
 #include <vga/textmode.hpp>
 
@@ -34,6 +38,8 @@ namespace Kernel
 		CPU::Processor::current().enable_interrupts();
 
 		Time::EventManager::instance().register_timer(&Time::PIT::instance());
+		Time::Clock::instance().calibrate();
+		Time::TimePage::instance().initialize();
 
 		Interrupts::APICTimer::instance().initialize();
 		Time::EventManager::instance().register_timer(&Interrupts::APICTimer::instance());
@@ -42,18 +48,23 @@ namespace Kernel
 
 		PCI::HostBridge::instance().init();
 		AHCIManager::instance().initialize();
+		Memory::SwapManager::instance().init();
 
 		/*
 		Tests::test_crtx();
 		Tests::test_heap();
 		Tests::test_printf();
 		Tests::test_vmm();
+		Tests::test_free_ranges();
 		 */
 
 		Interrupts::LAPIC::instance().start_smp_boot();
 
 		SyscallDispatcher::initialize();
 
+		FileSystemCache::initialize();
+		ELF::initialize();
+
 		// TODO: Get root partition through cmdline arguments
 		VirtualFileSystem::instance().initialize(AHCIManager::instance().devices()[0].partitions()[1]);
 
@@ -104,13 +115,14 @@ namespace Kernel
 
 	extern "C" __noreturn void ap_entry(uint32_t cpu_id)
 	{
-		mutex.lock();
+		// The GDT of the core is installed before the mutex is taken, as locking needs current()
 		CPU::Processor::early_initialize(cpu_id);
+		mutex.lock();
 		Interrupts::LAPIC::instance().set_ap_id(cpu_id);
 		Interrupts::LAPIC::instance().initialize_ap();
 		Interrupts::LAPIC::instance().enable();
 		CPU::Processor::initialize(cpu_id);
-		CPU::Processor::current().set_memory_space(Memory::VirtualMemoryManager::instance().get_kernel_memory_space());
+		Memory::VirtualMemoryManager::instance().init_ap();
 		CPU::Processor::current().smp_initialize_messaging();
 		Interrupts::APICTimer::instance().initialize();
 		mutex.unlock();
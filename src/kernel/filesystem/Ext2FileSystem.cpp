@@ -213,8 +213,10 @@ namespace Kernel
 		if (!is_type(FileType::RegularFile) && !is_type(FileType::SoftLink))
 			return 0;
 
-		if (offset + bytes > m_size)
-			bytes = m_size - offset;
+		uint64_t file_size = read_size();
+
+		if (offset + bytes > file_size)
+			bytes = file_size - offset;
 
 		if (is_type(FileType::SoftLink) && offset + bytes < EXT2_MAX_BYTES_FOR_SYMLINK_DIRECT)
 		{
@@ -260,7 +262,7 @@ namespace Kernel
 		if (!is_type(FileType::RegularFile))
 			return 0;
 
-		if (offset + bytes > m_size)
+		if (offset + bytes > read_size())
 		{
 			m_lock.lock();
 			uint64_t new_size = offset + bytes;
@@ -287,7 +289,10 @@ namespace Kernel
 				block_iterator.append_blocks(blocks);
 			}
 
+			m_size_seqlock.write_lock();
 			m_size = new_size;
+			m_size_seqlock.write_unlock();
+
 			m_inode_metadata.size_low = m_size & 0xFFFFFFFF;
 			m_inode_metadata.size_high = m_size >> 32;
 
@@ -365,7 +370,7 @@ namespace Kernel
 		if (!m_inode_metadata_cached)
 			read_and_parse_metadata();
 
-		return m_size;
+		return read_size();
 	}
 
 	FileType Ext2File::from_inode_type(Ext2::InodeType type)
@@ -394,7 +399,10 @@ namespace Kernel
 		m_inode_metadata = m_filesystem->read_inode_metadata(inode_number());
 		m_inode_metadata_cached = true;
 
+		m_size_seqlock.write_lock();
 		m_size = (uint64_t)m_inode_metadata.size_low | ((uint64_t)m_inode_metadata.size_high << 32);
+		m_size_seqlock.write_unlock();
+
 		m_type = from_inode_type(m_inode_metadata.permission_type.type);
 		m_lock.unlock();
 	}
@@ -496,6 +504,8 @@ namespace Kernel
 		memcpy(inode_ptr, &inode, sizeof(Ext2::inode_t));
 		FileSystemCache::sync(table_block);
 		FileSystemCache::release(table_block);
+
+		m_block_group_locks[block_group]->unlock();
 	}
 
 	LibK::vector<File *> Ext2FileSystem::read_directory(const Ext2::inode_t &inode)
@@ -650,6 +660,10 @@ namespace Kernel
 			if (count == 0)
 				break;
 
+			// Full groups are skipped without waiting for their lock, the count is checked again once the lock is held
+			if (get_block_group_descriptor(block_group)->unallocated_blocks == 0)
+				continue;
+
 			m_block_group_locks[block_group]->lock();
 
 			block_group_descriptor_t *block_group_descriptor = get_block_group_descriptor(block_group);
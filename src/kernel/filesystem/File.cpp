@@ -4,6 +4,8 @@
 
 namespace Kernel
 {
+	std::atomic<size_t> File::s_next_generation{1};
+
 	FileContext File::open(int options)
 	{
 		// TODO: parse options correctly
@@ -36,6 +36,11 @@ namespace Kernel
 	{
 		size_t actual_count = m_file->write(m_offset, count, buffer);
 		m_offset += actual_count;
+
+		// Bumped after the write, so anything built from the contents before or during it is never taken for current
+		if (actual_count > 0)
+			m_file->contents_changed();
+
 		return actual_count;
 	}
 
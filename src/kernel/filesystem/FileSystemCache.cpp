@@ -1,11 +1,22 @@
 #include <filesystem/FileSystemCache.hpp>
 
+#include <memory/ShrinkerRegistry.hpp>
+
 #include <libk/AVLTree.hpp>
 
 namespace Kernel
 {
 	static Locking::Mutex s_fs_cache_lock;
 	static LibK::AVLTree<fs_block_t> s_fs_cache;
+	static fs_block_t *s_lru_head{nullptr};
+	static fs_block_t *s_lru_tail{nullptr};
+
+	void FileSystemCache::initialize()
+	{
+		Memory::ShrinkerRegistry::instance().register_shrinker([](size_t page_count) {
+			return shrink(page_count);
+		});
+	}
 
 	fs_block_t *FileSystemCache::acquire(BlockDevice *device, size_t block)
 	{
@@ -19,8 +30,13 @@ namespace Kernel
 		if (fs_block)
 		{
 			fs_block->lock.lock();
+
+			if (fs_block->refcount == 0)
+				lru_remove(fs_block);
+
 			fs_block->refcount++;
 			fs_block->lock.unlock();
+			s_fs_cache_lock.unlock();
 			return fs_block;
 		}
 		s_fs_cache_lock.unlock();
@@ -51,17 +67,68 @@ namespace Kernel
 		block->lock.lock();
 		block->refcount--;
 
+		// The block is written back right away, so unused blocks can be evicted without any I/O
 		if (block->refcount == 0)
 		{
 			sync(block);
+			lru_append(block);
+		}
+
+		block->lock.unlock();
+		s_fs_cache_lock.unlock();
+	}
+
+	size_t FileSystemCache::shrink(size_t page_count)
+	{
+		// The allocation may come from within the cache itself, a contended cache is skipped instead of waited for
+		if (!s_fs_cache_lock.try_lock())
+			return 0;
+
+		size_t freed = 0;
+
+		while (freed < page_count && s_lru_head)
+		{
+			fs_block_t *block = s_lru_head;
+			lru_remove(block);
+
 			Memory::VirtualMemoryManager::instance().free(block->region);
 			bool removed = s_fs_cache.remove(*block);
 			assert(removed);
+
+			freed++;
 		}
-		else
-		{
-			block->lock.unlock();
-		}
+
 		s_fs_cache_lock.unlock();
+
+		return freed;
+	}
+
+	void FileSystemCache::lru_append(fs_block_t *block)
+	{
+		block->lru_prev = s_lru_tail;
+		block->lru_next = nullptr;
+
+		if (s_lru_tail)
+			s_lru_tail->lru_next = block;
+		else
+			s_lru_head = block;
+
+		s_lru_tail = block;
+	}
+
+	void FileSystemCache::lru_remove(fs_block_t *block)
+	{
+		if (block->lru_prev)
+			block->lru_prev->lru_next = block->lru_next;
+		else
+			s_lru_head = block->lru_next;
+
+		if (block->lru_next)
+			block->lru_next->lru_prev = block->lru_prev;
+		else
+			s_lru_tail = block->lru_prev;
+
+		block->lru_prev = nullptr;
+		block->lru_next = nullptr;
 	}
 }
@@ -37,12 +37,18 @@ namespace Kernel
 
 		vfs_node_t *current_file = &m_root_node;
 
+		// Nodes are never removed from the tree, so the pointers stay valid while the lock is dropped to read a directory
+		m_tree_lock.lock_shared();
+
 		while(!path.empty())
 		{
 			if (path[0] == '/')
 			{
 				if (!current_file->file->is_type(FileType::Directory))
+				{
+					m_tree_lock.unlock_shared();
 					return nullptr;
+				}
 
 				path.erase(path.begin());
 				continue;
@@ -68,8 +74,7 @@ namespace Kernel
 
 			assert(current_file->file->is_type(FileType::Directory));
 
-			if (current_file->children.empty())
-				read_directory(current_file);
+			read_directory_shared(current_file);
 
 			bool found = false;
 
@@ -84,8 +89,9 @@ namespace Kernel
 						// TODO: this is very wasteful with memory
 						// TODO: employ maximum recursion depth with ELOOP
 						handle_softlink(node, path);
-						LibK::string new_cwd = get_full_path(node->parent->file);
+						LibK::string new_cwd = build_full_path(node->parent->file);
 						new_cwd += '/';
+						m_tree_lock.unlock_shared();
 						return find_by_path(path, new_cwd);
 					}
 
@@ -99,9 +105,14 @@ namespace Kernel
 			}
 
 			if (!found)
+			{
+				m_tree_lock.unlock_shared();
 				return nullptr;
+			}
 		}
 
+		m_tree_lock.unlock_shared();
+
 		return current_file->file;
 	}
 
@@ -110,6 +121,16 @@ namespace Kernel
 		if (!file)
 			return "";
 
+		m_tree_lock.lock_shared();
+		LibK::string path = build_full_path(file);
+		m_tree_lock.unlock_shared();
+
+		return path;
+	}
+
+	LibK::string VirtualFileSystem::build_full_path(File *file)
+	{
+
 		LibK::string path;
 		LibK::stack<vfs_node_t *> path_entry_stack;
 
@@ -144,17 +165,36 @@ namespace Kernel
 
 		vfs_node_t *node = file->m_vfs_node;
 
-		if (node->children.empty())
-			read_directory(node);
+		m_tree_lock.lock_shared();
+
+		read_directory_shared(node);
 
 		LibK::vector<File *> children;
 		for (auto &child : node->children) {
 			children.push_back(child->file);
 		}
 
+		m_tree_lock.unlock_shared();
+
 		return children;
 	}
 
+	void VirtualFileSystem::read_directory_shared(vfs_node_t *node)
+	{
+		if (!node->children.empty())
+			return;
+
+		m_tree_lock.unlock_shared();
+		m_tree_lock.lock();
+
+		// Another thread might have read the directory in the meantime
+		if (node->children.empty())
+			read_directory(node);
+
+		m_tree_lock.unlock();
+		m_tree_lock.lock_shared();
+	}
+
 	void VirtualFileSystem::read_directory(vfs_node_t *node)
 	{
 		// TODO: think about changes in directory
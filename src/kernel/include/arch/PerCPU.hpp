@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/Processor.hpp>
+
+#include <libk/kcassert.hpp>
+
+namespace Kernel::CPU
+{
+	inline constexpr uint32_t MAX_CORES = 64;
+
+	// One instance of T per core, each on its own cache line so cores never contend over their neighbour's value.
+	// local() is only stable while the caller cannot be moved to another core (e.g. inside a critical section).
+	template <typename T>
+	class PerCPU
+	{
+	public:
+		[[nodiscard]] always_inline T &local() { return on(Processor::current().id()); }
+		[[nodiscard]] always_inline const T &local() const { return on(Processor::current().id()); }
+
+		[[nodiscard]] always_inline T &on(uint32_t id)
+		{
+			assert(id < MAX_CORES);
+			return m_slots[id].value;
+		}
+
+		[[nodiscard]] always_inline const T &on(uint32_t id) const
+		{
+			assert(id < MAX_CORES);
+			return m_slots[id].value;
+		}
+
+		// Calls func for the value of each running core
+		template <typename F>
+		void for_each(F func)
+		{
+			for (uint32_t id = 0; id < Processor::count(); id++)
+				func(id, m_slots[id].value);
+		}
+
+	private:
+		typedef struct alignas(64) slot_t
+		{
+			T value{};
+		} slot_t;
+
+		slot_t m_slots[MAX_CORES]{};
+	};
+} // namespace Kernel::CPU
@@ -5,7 +5,7 @@
 #include <libk/kfunctional.hpp>
 #include <libk/kshared_ptr.hpp>
 #include <libk/kstack.hpp>
-#include <libk/srmw_queue.hpp>
+#include <libk/mpsc_ring.hpp>
 
 #include <arch/i686/interrupts.hpp>
 #include <arch/i686/gdt.hpp>
@@ -32,9 +32,25 @@ namespace Kernel::CPU
 		friend ExceptionHandler;
 		friend PageFaultHandler;
 	public:
-		[[nodiscard]] static Processor &current();
+		// %gs points at m_self of the executing core, see install_boot_gdt() and early_initialize().
+		// The load is not volatile so back-to-back calls are merged. A thread only changes cores across a context switch,
+		// which clobbers memory and as such the anchor the load depends on, so the value is read again afterwards
+		[[nodiscard]] always_inline static Processor &current()
+		{
+			Processor *processor;
+
+			asm("movl %%gs:0, %0"
+			    : "=r"(processor)
+			    : "m"(s_current_anchor));
+
+			return *processor;
+		}
+
 		static void set_core_count(uint32_t core_count);
 
+		// Points %gs at the BSP through a static GDT, has to run before anything calls current()
+		static void install_boot_gdt();
+		// Installs the GDT of the core first, on the BSP this replaces the boot GDT
 		static void early_initialize(uint32_t id);
 		static void initialize(uint32_t id);
 
@@ -79,7 +95,7 @@ namespace Kernel::CPU
 		always_inline LibK::stack<interrupt_frame_t *> &get_interrupt_frame_stack() { return m_frame_stack; }
 		always_inline LibK::stack<LibK::function<void()>> &get_exit_function_stack() { return m_exit_function_stack; }
 
-		always_inline void set_memory_space(Memory::memory_space_t *memory_space) { m_memory_space = memory_space; }
+		void set_memory_space(Memory::memory_space_t *memory_space);
 		[[nodiscard]] always_inline Memory::memory_space_t *get_memory_space() const {
 			return m_memory_space;
 		}
@@ -98,6 +114,7 @@ namespace Kernel::CPU
 
 		static thread_t *create_kernel_thread(uintptr_t main_function);
 		static thread_t *create_userspace_thread(Memory::memory_space_t &memorySpace);
+		static void release_kernel_stack(thread_t *thread);
 		static void initialize_userspace_thread(thread_t *thread, uintptr_t main_function, Memory::memory_space_t &memory_space);
 		static thread_registers_t create_state_for_exec(uintptr_t main_function, uintptr_t userspace_stack_ptr, Memory::memory_space_t &memory_space);
 		static uintptr_t thread_push_userspace_data(thread_t *thread, const char *data, size_t count);
@@ -135,8 +152,9 @@ namespace Kernel::CPU
 		[[nodiscard]] bool is_thread_running() const { return m_current_thread; }
 		[[nodiscard]] thread_t *get_current_thread() const { return m_current_thread; }
 
-		[[nodiscard]] static uint64_t get_nanoseconds_since_boot();
-		void increment_nanoseconds_since_boot(uint64_t nanoseconds);
+		// Blocking on a Mutex halts until the timer switches away, which needs a thread with interrupts enabled and no spinlock held
+		[[nodiscard]] bool can_block() const { return m_scheduler_initialized && m_current_thread && m_in_critical == 0 && (eflags() & 0x200); }
+
 		always_inline void set_remaining_time_to_tick(uint64_t remaining_time_to_tick) { m_remaining_time_to_tick = remaining_time_to_tick; }
 		[[nodiscard]] always_inline uint64_t get_remaining_time_to_tick() const { return m_remaining_time_to_tick; }
 		always_inline void set_next_timer_tick(uint64_t next_timer_tick) { m_next_timer_tick = next_timer_tick; }
@@ -160,6 +178,23 @@ namespace Kernel::CPU
 
 			return cr2;
 		}
+
+		[[nodiscard]] always_inline static uintptr_t cr4()
+		{
+			uintptr_t cr4 = 0;
+
+			asm volatile("mov %%cr4, %%eax"
+			             : "=a"(cr4));
+
+			return cr4;
+		}
+
+		always_inline static void set_cr4(uintptr_t cr4)
+		{
+			asm volatile("mov %%eax, %%cr4" ::"a"(cr4)
+			             : "memory");
+		}
+
 		__noreturn always_inline static void halt()
 		{
 			for (;;)
@@ -169,7 +204,8 @@ namespace Kernel::CPU
 
 		always_inline static void sleep()
 		{
-			asm volatile("hlt");
+			// The thread may continue on another core, so current() has to be read again afterwards
+			asm volatile("hlt" ::: "memory");
 		}
 
 		always_inline static void pause()
@@ -177,6 +213,10 @@ namespace Kernel::CPU
 			asm volatile("pause");
 		}
 
+		// Spins a moment inside a critical section. Messages are handled meanwhile, as the core that is waited for might be
+		// waiting for this one to acknowledge a TLB shootdown, which could never arrive with interrupts disabled
+		static void relax();
+
 		always_inline static void load_page_directory(uintptr_t page_directory)
 		{
 			asm volatile("mov %%eax, %%cr3" ::"a"(page_directory)
@@ -218,6 +258,9 @@ namespace Kernel::CPU
 		}
 
 	private:
+		// Never written, it only ties current() to memory, see there
+		static inline char s_current_anchor{};
+
 		void init_gdt();
 		void init_idt();
 		void init_fault_handlers();
@@ -248,6 +291,7 @@ namespace Kernel::CPU
 			return eflags;
 		}
 
+		Processor *m_self{nullptr};
 		uint32_t m_id{0};
 		bool m_interrupts_enabled{false};
 		uint32_t m_in_critical{0};
@@ -268,10 +312,13 @@ namespace Kernel::CPU
 		CPU::tss_entry_t m_page_fault_tss{};
 		char *m_page_fault_stack{};
 
-		// TODO: Implement an actual FIFO data structure
-		LibK::SRMWQueue<LibK::shared_ptr<ProcessorMessage>> m_queued_messages{};
+		// Only this core takes from the rings, so they never need a lock
+		static constexpr size_t MESSAGE_RING_SIZE = 64;
+		static constexpr size_t DEFERRED_CALL_RING_SIZE = 256;
+
+		LibK::MPSCRing<LibK::shared_ptr<ProcessorMessage>, MESSAGE_RING_SIZE> m_queued_messages{};
 		Time::EventManager::EventQueue m_scheduled_events{};
-		LibK::SRMWQueue<LibK::function<void()>> m_deferred_calls{};
+		LibK::MPSCRing<LibK::function<void()>, DEFERRED_CALL_RING_SIZE> m_deferred_calls{};
 
 		bool m_scheduler_initialized{false};
 		uint64_t m_remaining_time_to_tick{};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <common_attributes.h>
+
+#define CPUID_LEAF_FEATURES       1
+#define CPUID_LEAF_EXTENDED_MAX   0x80000000
+#define CPUID_LEAF_ADVANCED_POWER 0x80000007
+
+#define CPUID_FEATURE_EDX_PSE (1 << 3)
+#define CPUID_FEATURE_EDX_TSC (1 << 4)
+#define CPUID_FEATURE_EDX_PGE (1 << 13)
+#define CPUID_FEATURE_EDX_PAT (1 << 16)
+
+#define CPUID_ADVANCED_POWER_EDX_INVARIANT_TSC (1 << 8)
+
+namespace Kernel
+{
+	typedef struct cpuid_t
+	{
+		uint32_t eax;
+		uint32_t ebx;
+		uint32_t ecx;
+		uint32_t edx;
+	} cpuid_t;
+
+	always_inline cpuid_t cpuid(uint32_t leaf)
+	{
+		cpuid_t result{};
+
+		asm volatile("cpuid" : "=a"(result.eax), "=b"(result.ebx), "=c"(result.ecx), "=d"(result.edx) : "a"(leaf), "c"(0));
+
+		return result;
+	}
+}
@@ -7,7 +7,10 @@
 
 namespace Kernel::CPU
 {
-	inline constexpr uint32_t GDT_ENTRY_COUNT = 8;
+	inline constexpr uint32_t GDT_ENTRY_COUNT = 9;
+
+	// Kernel data segment whose base is the owning core, loaded into %gs while running in the kernel
+	inline constexpr uint16_t PER_CPU_SELECTOR = 0x40;
 
 	typedef struct gdt_entry_t
 	{
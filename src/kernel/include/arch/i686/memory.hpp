@@ -1,11 +1,17 @@
 #pragma once
 
+#include <atomic>
+
 #include <stddef.h>
 #include <stdint.h>
 
 #include <common_attributes.h>
 
-#define PAGE_SIZE 4096
+#define PAGE_SIZE      4096
+#define PAGE_SIZE_HUGE (PAGE_SIZE * 1024)
+
+// Swapped out pages keep their slot in the address field of the page table entry
+#define SWAP_SLOT_LIMIT (1 << 20)
 
 namespace Kernel::Memory::Arch
 {
@@ -19,8 +25,9 @@ namespace Kernel::Memory::Arch
 		uint32_t accessed : 1;
 		uint32_t dirty : 1;
 		uint32_t page_attribute : 1;
-		uint32_t global : 1,
-		    : 3; // May be used for OS-specific things
+		uint32_t global : 1;
+		uint32_t swapped : 1, // Not present and the address field holds a swap slot
+		    : 2;              // May be used for OS-specific things
 		uint32_t page_address : 20;
 
 		inline void *page() { return (void *)(page_address << 12); }
@@ -41,11 +48,11 @@ namespace Kernel::Memory::Arch
 		uint32_t user : 1;
 		uint32_t write_through : 1;
 		uint32_t cache_disable : 1;
-		uint32_t accessed : 1,
-		    : 1; // Always zero
-		uint32_t page_size : 1,
-		    : 1, // Ignored
-		    : 3; // May be used for OS-specific things
+		uint32_t accessed : 1;
+		uint32_t dirty : 1; // Only used by 4 MiB pages
+		uint32_t page_size : 1;
+		uint32_t global : 1, // Only used by 4 MiB pages
+		    : 3;             // May be used for OS-specific things
 		uint32_t page_table_address : 20;
 
 		inline page_table_t *table() { return (page_table_t *)(page_table_address << 12); }
@@ -64,10 +71,13 @@ namespace Kernel::Memory::Arch
 		uintptr_t physical_pd_address;
 		page_directory_t *page_directory;
 		page_table_t *mapping_table;
-		uint64_t page_directory_version;
+
+		// Cores that have the space loaded, as far as their id fits into the mask. The kernel space has no mask, as every core uses it
+		std::atomic<uint32_t> *active_cores;
 	};
 
+	constexpr uint32_t ACTIVE_CORE_LIMIT = 32;
+
 	Arch::paging_space_t get_kernel_paging_space();
-	void check_page_directory();
 
 } // namespace Kernel::Memory::Arch
@@ -5,6 +5,8 @@
 
 #include <memory/definitions.hpp>
 
+#include <libk/kfunctional.hpp>
+
 namespace Kernel::Memory::Arch
 {
 	// Forward declaration to be overwritten
@@ -20,16 +22,38 @@ namespace Kernel::Memory::Arch
 	void initialize();
 
 	paging_space_t create_kernel_space();
+	void preallocate_kernel_page_tables();
 	paging_space_t create_memory_space();
 
 	void map(paging_space_t &memory_space, uintptr_t phys_addr, uintptr_t virt_addr, size_t size, mapping_config_t config);
+	// Both return only once no core can reach the unmapped pages anymore, so the caller may free them right away
 	void unmap(paging_space_t &memory_space, uintptr_t virt_addr, size_t size);
+	// Unmaps only the pages that are present and passes the physical address of each of them to the callback after the TLB shootdown,
+	// the slots of pages that have been swapped out are passed to the swap callback
+	void unmap_sparse(paging_space_t &memory_space, uintptr_t virt_addr, size_t size, const LibK::function<void(uintptr_t)> &callback, const LibK::function<void(size_t)> &swap_callback);
+	[[nodiscard]] bool is_mapped(paging_space_t &memory_space, uintptr_t virt_addr);
 	uintptr_t as_physical(uintptr_t virt_addr);
 	uintptr_t as_physical_for(paging_space_t &memory_space, uintptr_t virt_addr);
 
+	// Access a physical page without having to map it
+	void zero_page(uintptr_t phys_addr);
+	void copy_page(uintptr_t phys_addr, const void *source);
+	void copy_from_page(void *destination, uintptr_t phys_addr);
+
+	// Clears the accessed flag of a present page and returns whether it was set
+	bool test_and_clear_accessed(paging_space_t &memory_space, uintptr_t virt_addr);
+	// Replaces a present page by an entry that refers to the swap slot and returns the physical address of the page
+	uintptr_t set_swap_entry(paging_space_t &memory_space, uintptr_t virt_addr, size_t slot);
+	// Returns whether the page has been swapped out and stores its slot
+	[[nodiscard]] bool get_swap_entry(paging_space_t &memory_space, uintptr_t virt_addr, size_t &slot);
+
 	memory_region_t get_kernel_region();
 	memory_region_t get_mapping_region();
 
 	void load(paging_space_t &memory_space);
-	void invalidate(uintptr_t virtual_address);
+	// Flushes the range from the TLB of every core that may have it cached and waits until every core has done so.
+	// Only callers that free nothing the old entries pointed to may opt out of waiting
+	void invalidate(paging_space_t &memory_space, uintptr_t virt_addr, size_t size, bool wait = true);
+	// Allocates the shootdown message of the current core, which has to happen before the core sends any shootdown
+	void initialize_shootdowns();
 } // namespace Kernel::Memory::Arch
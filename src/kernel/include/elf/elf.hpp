@@ -6,8 +6,17 @@
 
 namespace Kernel::ELF
 {
-	// Basic loader to load the dynamic loader which loads the actual program
+	// Loaded segments of an executable, cached per inode and shared by every process that runs it
+	struct image_t;
+
+	// Registers the shrinker that drops cached images no process references anymore
+	void initialize();
+
+	// Basic loader to load the dynamic loader which loads the actual program, returns nullptr if the dynamic loader is missing
 	thread_t *load(Process *parent_process, File *file, const char **argv, const char **envp, bool is_exec_syscall);
 
 	bool is_executable(File *file);
+
+	void retain_image(image_t *image);
+	void release_image(image_t *image);
 }
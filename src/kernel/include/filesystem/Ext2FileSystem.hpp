@@ -3,6 +3,7 @@
 #include <filesystem/FileSystem.hpp>
 #include <filesystem/FileSystemCache.hpp>
 #include <locking/Mutex.hpp>
+#include <locking/Seqlock.hpp>
 #include <devices/BlockDevice.hpp>
 #include <memory/VirtualMemoryManager.hpp>
 
@@ -151,6 +152,12 @@ namespace Kernel
 
 		void read_and_parse_metadata();
 
+		// The size is 64 bits wide, so reading it while it is written could observe a torn value
+		[[nodiscard]] uint64_t read_size() const
+		{
+			return m_size_seqlock.read([this]() { return m_size; });
+		}
+
 		[[nodiscard]] bool can_open_for_read() const override { return true; };
 		[[nodiscard]] bool can_open_for_write() const override { return open_write_contexts() == 0; };
 
@@ -158,6 +165,7 @@ namespace Kernel
 		bool m_inode_metadata_cached{false};
 		Ext2::inode_t m_inode_metadata{};
 		uint64_t m_size{0};
+		Locking::Seqlock m_size_seqlock{};
 		LibK::string m_name{};
 
 		Locking::Mutex m_lock{};
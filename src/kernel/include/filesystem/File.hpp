@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include <stddef.h>
 
 #include <libk/StringView.hpp>
@@ -47,6 +49,7 @@ namespace Kernel
 	class File
 	{
 		friend class VirtualFileSystem;
+		friend class FileContext;
 
 	public:
 		// Basic file operations
@@ -74,9 +77,14 @@ namespace Kernel
 
 		[[nodiscard]] size_t inode_number() const { return m_inode_number; }
 
+		// Changes whenever the contents are written to. Generations are never shared between files, so a file that reuses
+		// the inode number of a removed one never looks like it
+		[[nodiscard]] size_t generation() { return std::atomic_ref(m_generation).load(std::memory_order_acquire); }
+
 	protected:
 		File()
 		    : m_mutex(new Locking::Mutex())
+		    , m_generation(s_next_generation.fetch_add(1, std::memory_order_relaxed))
 		{
 		}
 
@@ -95,6 +103,9 @@ namespace Kernel
 
 	private:
 		void set_vfs_node(vfs_node_t *node) { m_vfs_node = node; }
+		void contents_changed() { std::atomic_ref(m_generation).store(s_next_generation.fetch_add(1, std::memory_order_relaxed), std::memory_order_release); }
+
+		static std::atomic<size_t> s_next_generation;
 
 		vfs_node_t *m_vfs_node{nullptr};
 
@@ -104,5 +115,7 @@ namespace Kernel
 		size_t m_inode_number{0};
 
 		Locking::Mutex *m_mutex{};
+
+		size_t m_generation;
 	};
 } // namespace Kernel
@@ -13,17 +13,30 @@ namespace Kernel
 		Locking::Mutex lock{};
 		size_t refcount{0};
 
+		// Unused blocks are kept in least recently used order
+		__fs_block_t *lru_prev{nullptr};
+		__fs_block_t *lru_next{nullptr};
+
 		bool operator==(const __fs_block_t &other) const { return this->device == other.device && this->block == other.block; }
 		bool operator<(const __fs_block_t &other) const { return this->device < other.device || (this->device == other.device && this->block < other.block); }
 
 		[[nodiscard]] char *data() const { return (char *)region.virt_region().pointer(); };
 	} fs_block_t;
 
+	// Blocks stay cached after their last user released them, until memory runs low and the shrinker evicts them
 	class FileSystemCache
 	{
 	public:
+		static void initialize();
+
 		static fs_block_t *acquire(BlockDevice *device, size_t block);
 		static void sync(fs_block_t *block);
 		static void release(fs_block_t *block);
+
+	private:
+		static void lru_append(fs_block_t *block);
+		static void lru_remove(fs_block_t *block);
+
+		static size_t shrink(size_t page_count);
 	};
 }
@@ -5,6 +5,7 @@
 #include <libk/kstring.hpp>
 
 #include <filesystem/definitions.hpp>
+#include <locking/RWMutex.hpp>
 #include <storage/PartitionDevice.hpp>
 
 namespace Kernel
@@ -46,9 +47,16 @@ namespace Kernel
 
 		FileSystem *initialize_filesystem_on(BlockDevice &device);
 
+		// The following methods expect the tree lock to be held, read_directory exclusively and the others shared
+		LibK::string build_full_path(File *file);
 		void read_directory(vfs_node_t *node);
+		// Drops the shared lock in between to read the directory if its children are not known yet
+		void read_directory_shared(vfs_node_t *node);
 
 		FileSystem *m_root_fs{nullptr};
 		vfs_node_t m_root_node{};
+
+		// Path lookups only read the tree, only reading new directories into it needs the lock exclusively
+		Locking::RWMutex m_tree_lock{};
 	};
 }
@@ -146,6 +146,30 @@ namespace Kernel::LibK
 			return node ? &node->value : nullptr;
 		}
 
+		// Returns the smallest value that is not less than key
+		const T *lower_bound(const T &key) const
+		{
+			node_t *current = m_tree;
+			node_t *result = nullptr;
+
+			while (current)
+			{
+				if (current->value < key)
+				{
+					current = current->right;
+				}
+				else
+				{
+					result = current;
+					current = current->left;
+				}
+			}
+
+			return result ? &result->value : nullptr;
+		}
+
+		[[nodiscard]] bool empty() const { return !m_tree; }
+
 	private:
 		static void delete_subtree(node_t *tree)
 		{
@@ -250,7 +274,11 @@ namespace Kernel::LibK
 
 				successor->parent = node->parent;
 
-				if (node->parent->left == node)
+				if (!node->parent)
+				{
+					m_tree = successor;
+				}
+				else if (node->parent->left == node)
 				{
 					node->parent->left = successor;
 				}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libk/kutility.hpp>
+
+namespace Kernel::LibK
+{
+	// Bounded lock-free queue for many producers and a single consumer, the slots are allocated up front so putting never allocates.
+	// Every slot carries a sequence number that tells producers and the consumer whose turn it is to use it.
+	template <typename T, size_t Capacity>
+	class MPSCRing
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity has to be a power of two");
+
+		typedef struct slot_t
+		{
+			std::atomic<size_t> sequence;
+			T data;
+		} slot_t;
+
+	public:
+		MPSCRing()
+		{
+			for (size_t i = 0; i < Capacity; i++)
+				m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		MPSCRing(const MPSCRing &) = delete;
+		MPSCRing &operator=(const MPSCRing &) = delete;
+
+		// Returns false if the ring is full
+		bool try_put(T &&data)
+		{
+			size_t position = m_tail.load(std::memory_order_relaxed);
+			slot_t *slot;
+
+			while (true)
+			{
+				slot = &m_slots[position & (Capacity - 1)];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				auto distance = static_cast<intptr_t>(sequence - position);
+
+				if (distance == 0)
+				{
+					if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (distance < 0)
+				{
+					// The consumer has not taken the data of the previous round yet
+					return false;
+				}
+				else
+				{
+					position = m_tail.load(std::memory_order_relaxed);
+				}
+			}
+
+			slot->data = std::move(data);
+			slot->sequence.store(position + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		// May only be called by the consumer, returns false if the ring is empty
+		bool try_get(T &data)
+		{
+			slot_t &slot = m_slots[m_head & (Capacity - 1)];
+
+			if (slot.sequence.load(std::memory_order_acquire) != m_head + 1)
+				return false;
+
+			data = std::move(slot.data);
+			slot.data = T();
+			slot.sequence.store(m_head + Capacity, std::memory_order_release);
+			m_head++;
+
+			return true;
+		}
+
+		[[nodiscard]] bool empty() const
+		{
+			return m_slots[m_head & (Capacity - 1)].sequence.load(std::memory_order_acquire) != m_head + 1;
+		}
+
+	private:
+		slot_t m_slots[Capacity]{};
+
+		alignas(64) std::atomic<size_t> m_tail{0}; // Producers and the consumer work on separate cache lines
+		alignas(64) size_t m_head{0};
+	};
+} // namespace Kernel::LibK
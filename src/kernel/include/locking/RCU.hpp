@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/PerCPU.hpp>
+#include <arch/spinlock.hpp>
+
+#include <libk/kfunctional.hpp>
+#include <libk/kvector.hpp>
+
+namespace Kernel::Locking
+{
+	// Deferred reclamation for data that is read without locks.
+	// Readers only disable preemption, updaters unlink the old data and pass its destruction to call(), which runs it once every core
+	// has passed through the scheduler since, at that point no reader can still see the old data.
+	class RCU
+	{
+	public:
+		static RCU &instance()
+		{
+			static RCU *instance{nullptr};
+
+			if (!instance)
+				instance = new RCU();
+
+			return *instance;
+		}
+
+		RCU(RCU &) = delete;
+		void operator=(const RCU &) = delete;
+
+		// Read-side sections must not block
+		static void read_lock();
+		static void read_unlock();
+
+		void call(LibK::function<void()> &&callback);
+
+		// Called by the scheduler of each core whenever it switches threads, runs the callbacks that have become safe
+		void quiescent_state();
+
+	private:
+		RCU() = default;
+		~RCU() = default;
+
+		typedef struct callback_t
+		{
+			uint32_t epoch;
+			LibK::function<void()> function;
+		} callback_t;
+
+		[[nodiscard]] uint32_t completed_epoch() const;
+
+		std::atomic<uint32_t> m_epoch{0};
+		// The epoch each core has seen at its latest quiescent state
+		CPU::PerCPU<std::atomic<uint32_t>> m_core_epochs{};
+
+		LibK::vector<callback_t> m_callbacks{};
+		Spinlock m_lock{};
+	};
+} // namespace Kernel::Locking
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <locking/Mutex.hpp>
+
+namespace Kernel::Locking
+{
+	// Sleeping lock that allows multiple concurrent readers or a single writer, for read-mostly data that is held across blocking operations.
+	// Waiting writers block new readers from entering to prevent writer starvation.
+	class RWMutex
+	{
+	public:
+		RWMutex() = default;
+		RWMutex &operator=(const RWMutex &) = delete;
+		RWMutex &operator=(RWMutex &&) = delete;
+		RWMutex(const RWMutex &) = delete;
+		RWMutex(RWMutex &&) = delete;
+
+		void lock();
+		void unlock();
+
+		void lock_shared();
+		void unlock_shared();
+
+		[[nodiscard]] always_inline bool is_locked() const { return m_resource.is_locked(); }
+
+	private:
+		// Held by the writer or on behalf of all readers together
+		Mutex m_resource{};
+		// Held by a writer from the moment it waits, so no new reader gets in before it
+		Mutex m_turnstile{};
+		Mutex m_readers_lock{};
+		size_t m_readers{0};
+	};
+} // namespace Kernel::Locking
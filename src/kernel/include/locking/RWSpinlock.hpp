@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+
+#include <stdint.h>
+
+#include <common_attributes.h>
+
+namespace Kernel::Locking
+{
+	// Spinlock that allows multiple concurrent readers or a single writer.
+	// Waiting writers block new readers from entering to prevent writer starvation.
+	class RWSpinlock
+	{
+	public:
+		RWSpinlock() = default;
+		RWSpinlock &operator=(const RWSpinlock &) = delete;
+		RWSpinlock &operator=(RWSpinlock &&) = delete;
+		RWSpinlock(const RWSpinlock &) = delete;
+		RWSpinlock(RWSpinlock &&) = delete;
+
+		void lock();
+		bool try_lock();
+		void unlock();
+
+		void lock_shared();
+		void unlock_shared();
+
+		[[nodiscard]] always_inline bool is_locked() const noexcept { return m_state.load(std::memory_order_relaxed) & WRITER; }
+		[[nodiscard]] always_inline bool is_locked_shared() const noexcept { return m_state.load(std::memory_order_relaxed) & READER_MASK; }
+
+	private:
+		static constexpr uint32_t WRITER = 1u << 31;
+		static constexpr uint32_t WRITER_PENDING = 1u << 30;
+		static constexpr uint32_t READER_MASK = WRITER_PENDING - 1;
+
+		alignas(64) std::atomic<uint32_t> m_state{0}; // lock will be aligned on cache line boundary
+	};
+} // namespace Kernel::Locking
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+
+#include <stdint.h>
+
+#include <arch/spinlock.hpp>
+
+#include <common_attributes.h>
+
+namespace Kernel::Locking
+{
+	// Readers never write to the lock, they copy the protected data and retry if a writer was active in the meantime.
+	// Only suited for small data that is read much more often than it is written, readers must not follow pointers into it.
+	class Seqlock
+	{
+	public:
+		Seqlock() = default;
+		Seqlock &operator=(const Seqlock &) = delete;
+		Seqlock &operator=(Seqlock &&) = delete;
+		Seqlock(const Seqlock &) = delete;
+		Seqlock(Seqlock &&) = delete;
+
+		[[nodiscard]] uint32_t read_begin() const;
+		[[nodiscard]] bool read_retry(uint32_t sequence) const;
+
+		void write_lock();
+		void write_unlock();
+
+		// Reads the data through the given function until no writer interfered
+		template <typename Func>
+		always_inline auto read(Func func) const
+		{
+			while (true)
+			{
+				uint32_t sequence = read_begin();
+				auto value = func();
+
+				if (!read_retry(sequence))
+					return value;
+			}
+		}
+
+	private:
+		std::atomic<uint32_t> m_sequence{0};
+		Spinlock m_lock{};
+	};
+} // namespace Kernel::Locking
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+
+#include <stdint.h>
+
+#include <common_attributes.h>
+
+namespace Kernel::Locking
+{
+	// Spinlock that hands the lock to waiting cores in the order they arrived, so no core starves on a contended lock.
+	// Locks that are given a name keep contention statistics, these locks have to live as long as the kernel does.
+	class TicketLock
+	{
+	public:
+		TicketLock() = default;
+		explicit TicketLock(const char *name);
+		TicketLock &operator=(const TicketLock &) = delete;
+		TicketLock &operator=(TicketLock &&) = delete;
+		TicketLock(const TicketLock &) = delete;
+		TicketLock(TicketLock &&) = delete;
+
+		bool try_lock();
+		void lock();
+		void unlock();
+
+		[[nodiscard]] always_inline bool is_locked() const noexcept
+		{
+			return m_next_ticket.load(std::memory_order_relaxed) != m_now_serving.load(std::memory_order_relaxed);
+		}
+
+		// Logs the statistics of every named lock
+		static void dump_statistics();
+
+	private:
+		// Only modified while the lock is held
+		typedef struct statistics_t
+		{
+			uint32_t acquisitions;
+			uint32_t contentions;
+			uint64_t spins;
+			uint64_t max_hold_time; // In TSC ticks
+			uint64_t acquired_at;
+		} statistics_t;
+
+		void acquired(uint32_t spins);
+
+		alignas(64) std::atomic<uint16_t> m_next_ticket{0}; // lock will be aligned on cache line boundary
+		std::atomic<uint16_t> m_now_serving{0};
+
+		const char *m_name{nullptr};
+		statistics_t m_statistics{};
+		TicketLock *m_next_named{nullptr};
+
+		static std::atomic<TicketLock *> s_named_locks;
+	};
+} // namespace Kernel::Locking
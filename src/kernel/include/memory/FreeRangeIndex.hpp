@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory/definitions.hpp>
+
+#include <libk/AVLTree.hpp>
+
+namespace Kernel::Memory
+{
+	// Index of the unmapped ranges of an address space.
+	// Every free range is stored twice: ordered by address to coalesce neighbours when a range is released,
+	// and ordered by size to answer best-fit queries in O(log n).
+	class FreeRangeIndex
+	{
+	public:
+		FreeRangeIndex() = default;
+		explicit FreeRangeIndex(region_t range) { release(range); }
+
+		FreeRangeIndex(FreeRangeIndex &&) noexcept = default;
+		FreeRangeIndex &operator=(FreeRangeIndex &&) noexcept = default;
+
+		// Returns the smallest free range of at least the given size or an empty region
+		[[nodiscard]] region_t find_best_fit(size_t size) const;
+
+		void reserve(const region_t &range);
+		void release(const region_t &range);
+
+	private:
+		typedef struct sized_region_t
+		{
+			region_t range;
+
+			bool operator==(const sized_region_t &other) const { return range.size == other.range.size && range.address == other.range.address; }
+			bool operator<(const sized_region_t &other) const { return range.size < other.range.size || (range.size == other.range.size && range.address < other.range.address); }
+		} sized_region_t;
+
+		void insert(const region_t &range);
+		void remove(const region_t &range);
+
+		LibK::AVLTree<region_t> m_by_address{};
+		LibK::AVLTree<sized_region_t> m_by_size{};
+	};
+} // namespace Kernel::Memory
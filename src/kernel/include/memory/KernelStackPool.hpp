@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/spinlock.hpp>
+#include <memory/definitions.hpp>
+
+#include <libk/kvector.hpp>
+
+namespace Kernel::Memory
+{
+	// Kernel stacks of kernel threads, each one sits above an unmapped guard page so an overflow faults instead of corrupting memory.
+	// Stacks of terminated threads are recycled instead of being freed, as such the pool grows up to the most kernel threads alive at once.
+	class KernelStackPool
+	{
+	public:
+		static KernelStackPool &instance()
+		{
+			static KernelStackPool *instance{nullptr};
+
+			if (!instance)
+				instance = new KernelStackPool();
+
+			return *instance;
+		}
+
+		KernelStackPool(KernelStackPool &) = delete;
+		void operator=(const KernelStackPool &) = delete;
+
+		// Returns a region of KERNEL_STACK_SIZE bytes, the page below it is the guard page
+		[[nodiscard]] memory_region_t allocate();
+		void release(const memory_region_t &stack);
+
+	private:
+		KernelStackPool() = default;
+		~KernelStackPool() = default;
+
+		[[nodiscard]] static memory_region_t create_stack();
+
+		LibK::vector<memory_region_t> m_free_stacks{};
+
+		Locking::Spinlock m_lock{};
+	};
+} // namespace Kernel::Memory
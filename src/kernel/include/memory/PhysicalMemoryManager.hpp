@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory/MultibootMap.hpp>
+#include <arch/memory.hpp>
 #include <arch/spinlock.hpp>
+#include <locking/TicketLock.hpp>
 
 #include <limits.h>
 #include <multiboot.h>
@@ -10,17 +12,40 @@
 
 namespace Kernel::Memory
 {
+	enum class Zone
+	{
+		DMA,    // Reachable by legacy devices (below 16 MiB)
+		Normal, // Everything else
+	};
+
 	class PhysicalMemoryManager
 	{
 	private:
+		static constexpr size_t BUDDY_COUNT = 8;
+		static constexpr size_t ZONE_COUNT = 2;
+		static constexpr uintptr_t DMA_ZONE_END = 16 * 1024 * 1024;
+		static constexpr size_t ZONE_WATERMARK_RATIO = 16;
+
 		typedef struct buddy_t
 		{
 			size_t page_size;
 			size_t page_count;
-			size_t last_alloc;
 			uint32_t *bitmap;
 		} buddy_t;
 
+		// Zones split the pages of a node, so constrained allocations only search the pages that can satisfy them.
+		// There is only a single node for now, but zones carry theirs so per-node pools can be added later on.
+		typedef struct zone_t
+		{
+			Zone type;
+			size_t node;
+			size_t start_page; // First page of the zone
+			size_t end_page;   // One past the last page of the zone
+			size_t free_pages;
+			size_t watermark; // Pages kept free for allocations that can only be served by this zone
+			size_t last_alloc[BUDDY_COUNT];
+		} zone_t;
+
 	public:
 		static PhysicalMemoryManager &instance()
 		{
@@ -42,6 +67,9 @@ namespace Kernel::Memory
 		void *alloc(size_t size, uint32_t min_address = 0, uint32_t max_address = UINT32_MAX, uint32_t boundary = 0);
 		void free(void *page, size_t size);
 
+		[[nodiscard]] size_t get_free_memory() const { return m_available_memory - m_used_memory; }
+		[[nodiscard]] size_t get_free_memory(Zone zone) const { return m_zones[static_cast<size_t>(zone)].free_pages * PAGE_SIZE; }
+
 	private:
 		PhysicalMemoryManager() = default;
 		~PhysicalMemoryManager() = default;
@@ -59,7 +87,12 @@ namespace Kernel::Memory
 
 		size_t get_buddy(size_t size);
 
-		buddy_t m_buddies[8];
+		void init_zone(Zone type, uintptr_t start_address, uintptr_t end_address);
+		zone_t &get_zone(size_t page_idx);
+		void *alloc_from(zone_t &zone, size_t size, uint32_t min_address, uint32_t max_address, uint32_t boundary);
+
+		buddy_t m_buddies[BUDDY_COUNT];
+		zone_t m_zones[ZONE_COUNT];
 		MultibootMap m_memory_map;
 
 		size_t m_available_memory{0};     // Available memory in the system
@@ -67,6 +100,6 @@ namespace Kernel::Memory
 		size_t m_explicit_used_memory{0}; // Memory that is explicitly used according to allocations
 
 		// TODO: look into lockless designs
-		Locking::Spinlock m_lock{};
+		Locking::TicketLock m_lock{"pmm"};
 	};
 } // namespace Kernel::Memory
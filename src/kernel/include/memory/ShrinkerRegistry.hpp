@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/spinlock.hpp>
+
+#include <libk/kfunctional.hpp>
+#include <libk/kvector.hpp>
+
+namespace Kernel::Memory
+{
+	// Caches register a shrinker to give memory back before an allocation runs out of physical memory or kernel address space.
+	// Shrinkers are called from within allocations, as such they should skip whatever is locked instead of waiting for it.
+	class ShrinkerRegistry
+	{
+	public:
+		// Frees up to the given amount of pages and returns how many pages were actually freed
+		typedef LibK::function<size_t(size_t)> shrinker_t;
+
+		static ShrinkerRegistry &instance()
+		{
+			static ShrinkerRegistry *instance{nullptr};
+
+			if (!instance)
+				instance = new ShrinkerRegistry();
+
+			return *instance;
+		}
+
+		ShrinkerRegistry(ShrinkerRegistry &) = delete;
+		void operator=(const ShrinkerRegistry &) = delete;
+
+		void register_shrinker(shrinker_t &&shrinker);
+
+		// Asks every shrinker in turn until page_count pages have been freed, returns the amount of freed pages
+		size_t shrink(size_t page_count);
+
+	private:
+		ShrinkerRegistry() = default;
+		~ShrinkerRegistry() = default;
+
+		static constexpr uint32_t NO_OWNER = UINT32_MAX;
+
+		LibK::vector<shrinker_t> m_shrinkers{};
+
+		// Shrinking may allocate memory itself, the owner makes sure this does not recurse
+		Locking::Spinlock m_lock{};
+		std::atomic<uint32_t> m_owner{NO_OWNER};
+	};
+} // namespace Kernel::Memory
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/spinlock.hpp>
+#include <locking/Mutex.hpp>
+#include <memory/VirtualMemoryManager.hpp>
+#include <processes/definitions.hpp>
+#include <storage/PartitionDevice.hpp>
+
+#include <libk/kvector.hpp>
+
+namespace Kernel::Memory
+{
+	// Evicts cold pages of reserved userland memory to a swap partition once physical memory runs out.
+	// Pages are picked by a second chance scan over their accessed flags and are read back in on the next fault.
+	// The disk is only accessed without any spinlock held, as the port may block. Only the holder of the io lock
+	// moves pages in and out of swap, which keeps the slots and swap entries stable while no other lock is held.
+	class SwapManager
+	{
+	public:
+		static SwapManager &instance()
+		{
+			static SwapManager *instance{nullptr};
+
+			if (!instance)
+				instance = new SwapManager();
+
+			return *instance;
+		}
+
+		SwapManager(SwapManager &) = delete;
+		void operator=(const SwapManager &) = delete;
+
+		// Looks for a swap partition on the connected storage devices
+		void init();
+
+		[[nodiscard]] bool is_available() const { return m_partition != nullptr; }
+
+		void add_memory_space(memory_space_t *memory_space);
+		// Has to be called before the memory space is torn down, waits for transfers that may still refer to it
+		void remove_memory_space(memory_space_t *memory_space);
+
+		// Evicts up to page_count pages and returns how many physical pages have been freed.
+		// Does nothing if the caller cannot block, e.g. for allocations made under a spinlock
+		size_t page_out(size_t page_count);
+
+		// Pages out a batch ahead of time when free memory runs low
+		void balance();
+
+		// The following methods may block, so the caller must not hold any spinlock
+
+		// Reads the page back in and maps it, unless it has been swapped in or unmapped in the meantime
+		bool swap_in(memory_space_t *memory_space, uintptr_t virt_address, mapping_config_t config);
+		// Reads the page into the frame while keeping it swapped out, returns false if the page is not swapped out anymore
+		bool read(memory_space_t *memory_space, uintptr_t virt_address, uintptr_t phys_address);
+
+		// Frees the slot of a swap entry that has been removed, the lock of its memory space may be held
+		void release(size_t slot);
+
+	private:
+		SwapManager() = default;
+		~SwapManager() = default;
+
+		static constexpr size_t NO_SLOT = SIZE_MAX;
+		static constexpr size_t LOW_FREE_MEMORY = 2 * 1024 * 1024;
+		static constexpr size_t BALANCE_BATCH = 32;
+
+		// A page that has been replaced by a swap entry but not written out yet
+		typedef struct victim_t
+		{
+			memory_space_t *memory_space;
+			uintptr_t virt_address;
+			uintptr_t phys_address;
+			size_t slot;
+			mapping_config_t config;
+		} victim_t;
+
+		void lock_io();
+		void unlock_io();
+
+		// The following methods expect the io lock to be held
+		[[nodiscard]] size_t select_victims(size_t limit);
+		bool write_victim(const victim_t &victim);
+		bool read_page(memory_space_t *memory_space, uintptr_t virt_address, uintptr_t phys_address, size_t &slot);
+		bool transfer(size_t slot, bool is_write);
+
+		// The following methods expect m_lock to be held
+		[[nodiscard]] size_t select_victims_from(memory_space_t &memory_space, victim_t *victims, size_t limit);
+		[[nodiscard]] size_t allocate_slot();
+		void free_slot(size_t slot);
+
+		PartitionDevice *m_partition{nullptr};
+		size_t m_blocks_per_slot{0};
+		size_t m_slot_count{0};
+		size_t m_used_slots{0};
+		size_t m_next_slot{0};
+		uint32_t *m_slot_bitmap{nullptr};
+
+		// Bounce buffer for the transfers, the pages themselves are not mapped in kernel space
+		memory_region_t m_buffer{};
+		victim_t m_victims[BALANCE_BATCH]{};
+
+		LibK::vector<memory_space_t *> m_memory_spaces{};
+		size_t m_next_memory_space{0};
+
+		// Serializes the transfers and owns the buffer and the victims. Allocations made while paging out must not
+		// recurse into it, the owner is checked for that
+		Locking::Mutex m_io_lock{};
+		std::atomic<thread_t *> m_io_owner{nullptr};
+
+		// Guards the slots and the memory spaces, it is never held across a transfer
+		Locking::Spinlock m_lock{};
+	};
+} // namespace Kernel::Memory
@@ -4,11 +4,13 @@
 #include <stdint.h>
 
 #include <arch/memory.hpp>
-#include <arch/spinlock.hpp>
+#include <locking/RWSpinlock.hpp>
+#include <memory/FreeRangeIndex.hpp>
 #include <memory/definitions.hpp>
 #include <multiboot.h>
 
 #include <libk/kfunctional.hpp>
+#include <libk/kshared_ptr.hpp>
 #include <libk/kvector.hpp>
 #include <libk/AVLTree.hpp>
 
@@ -18,6 +20,10 @@ namespace Kernel::Memory
 	{
 		Arch::paging_space_t paging_space;
 		LibK::AVLTree<memory_region_t> userland_map;
+		FreeRangeIndex userland_free_ranges;
+
+		// Protects the userland map and free ranges, allocated once so the memory space can be moved and freed with its last copy
+		LibK::shared_ptr<Locking::RWSpinlock> lock;
 	} memory_space_t;
 
 	class VirtualMemoryManager
@@ -37,6 +43,7 @@ namespace Kernel::Memory
 		void operator=(const VirtualMemoryManager &) = delete;
 
 		void init(multiboot_info_t *&mulitboot_info);
+		void init_ap();
 
 		memory_region_t allocate_region(size_t size, mapping_config_t config = {});
 		memory_region_t allocate_region_at(uintptr_t virt_addr, size_t size, mapping_config_t config = {});
@@ -60,9 +67,20 @@ namespace Kernel::Memory
 
 		memory_region_t allocate_region_at_for(memory_space_t *memory_space, uintptr_t virt_addr, size_t size, mapping_config_t config = {});
 
+		// Reserve virtual memory that gets backed by zeroed pages once it is touched
+		memory_region_t reserve_region(size_t size, mapping_config_t config = {});
+		memory_region_t reserve_region_at_for(memory_space_t *memory_space, uintptr_t virt_addr, size_t size, mapping_config_t config = {});
+
+		// Maps physical pages that other memory spaces map as well, writeable regions get a private copy of a page on its first write
+		memory_region_t share_region_at(uintptr_t phys_addr, uintptr_t virt_addr, size_t size, mapping_config_t config = {});
+
+		// Returns whether the fault was resolved by backing a reserved page, reading it back from swap or copying a shared page
+		bool handle_page_fault(uintptr_t virt_addr, bool is_present);
+
 		void free(void *ptr);
 		void free(const memory_region_t &region);
 
+		// NOTE: The returned region is only guaranteed to stay valid as long as nobody unmaps it concurrently
 		[[nodiscard]] const memory_region_t *find_region(memory_space_t *memory_space, uintptr_t virtual_addr);
 
 		void enumerate(const LibK::function<bool(memory_region_t)> &callback);
@@ -79,22 +97,40 @@ namespace Kernel::Memory
 
 		[[nodiscard]] bool check_free(memory_space_t *memory_space, const region_t &region) const;
 
-		[[nodiscard]] region_t find_free_region(memory_space_t *memory_space, size_t size, bool is_kernel_space) const;
+		[[nodiscard]] Locking::RWSpinlock &get_lock(memory_space_t *memory_space, bool is_kernel_space);
+
+		// The following methods expect the lock of the corresponding address space to be held
+		[[nodiscard]] const memory_region_t *lookup(memory_space_t *memory_space, uintptr_t virtual_addr) const;
+		// NOTE: Drops the kernel lock in between to let the shrinkers release kernel address space
+		[[nodiscard]] region_t find_free_region(memory_space_t *memory_space, size_t size, bool is_kernel_space);
+		[[nodiscard]] uintptr_t find_free_address(memory_space_t *memory_space, uintptr_t phys_address, size_t size, mapping_config_t config);
 
 		memory_region_t map(memory_space_t *memory_space, uintptr_t phys_address, uintptr_t virt_address, size_t size, mapping_config_t config);
+		memory_region_t reserve(memory_space_t *memory_space, uintptr_t virt_address, size_t size, mapping_config_t config);
+		void populate(memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address, const void *source);
+		memory_region_t share(memory_space_t *memory_space, uintptr_t phys_address, uintptr_t virt_address, size_t size, mapping_config_t config);
+		void copy_on_write(memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address);
+		[[nodiscard]] bool is_shared_page(memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address) const;
 		void unmap(memory_space_t *memory_space, const memory_region_t &region);
 
+		// Copies a swapped out page of the source into the memory space, which is not the current one. No lock may be held, as the disk is read
+		void copy_swapped_page(memory_space_t *source_space, memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address);
+
 		void traverse_all(memory_space_t *memory_space, bool is_kernel_space, const LibK::function<bool(memory_region_t)> &callback) const;
 		void traverse_unmapped(memory_space_t *memory_space, bool is_kernel_space, const LibK::function<bool(memory_region_t)> &callback) const;
 		void traverse_mapped(memory_space_t *memory_space, bool is_kernel_space, const LibK::function<bool(memory_region_t)> &callback) const;
 
 		bool in_kernel_space(uintptr_t virt_address) const;
 
+		static region_t get_userland_range();
+		static region_t get_kernel_space_range();
+
 		memory_space_t m_kernel_memory_space{};
 		Arch::paging_space_t m_kernel_paging_space{};
 		LibK::AVLTree<memory_region_t> m_kernel_memory_map{};
+		FreeRangeIndex m_kernel_free_ranges{};
 
-		// TODO: Implement a lockless design
-		Locking::Spinlock m_lock{};
+		// Protects the kernel map and free ranges, userland is protected per memory space
+		Locking::RWSpinlock m_kernel_lock{};
 	};
 } // namespace Kernel::Memory
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/spinlock.hpp>
+
+namespace Kernel::Memory
+{
+	// Physical pages that have been zeroed ahead of time by the idle threads,
+	// so backing demand-zero memory does not have to clear the page while the faulting thread waits.
+	class ZeroPagePool
+	{
+	public:
+		static ZeroPagePool &instance()
+		{
+			static ZeroPagePool *instance{nullptr};
+
+			if (!instance)
+				instance = new ZeroPagePool();
+
+			return *instance;
+		}
+
+		ZeroPagePool(ZeroPagePool &) = delete;
+		void operator=(const ZeroPagePool &) = delete;
+
+		// Returns the physical address of a zeroed page or 0 if the pool is empty
+		[[nodiscard]] uintptr_t take();
+
+		// Zeroes a single page into the pool, returns false if there is nothing left to do
+		bool refill();
+
+		// Gives up to page_count pages back to the physical memory manager, returns how many pages were freed
+		size_t drain(size_t page_count);
+
+		[[nodiscard]] size_t size() const { return m_count; }
+
+	private:
+		ZeroPagePool();
+		~ZeroPagePool() = default;
+
+		static constexpr size_t CAPACITY = 512;
+		static constexpr size_t MIN_FREE_MEMORY = 8 * 1024 * 1024; // Never hoard the last free pages of the system
+
+		uintptr_t m_pages[CAPACITY]{};
+		size_t m_count{0};
+
+		Locking::Spinlock m_lock{};
+	};
+} // namespace Kernel::Memory
@@ -59,6 +59,12 @@ namespace Kernel::Memory
 		};
 
 		size_t alignment = 0;
+
+		// Hint to map the region using huge pages where the physical and virtual addresses allow it
+		bool huge_pages = false;
+
+		// The physical pages are mapped by other memory spaces as well and are never freed along with the region
+		bool shared = false;
 	} mapping_config_t;
 
 	typedef struct memory_region_t
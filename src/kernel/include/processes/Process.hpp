@@ -12,6 +12,11 @@
 #include <memory/VirtualMemoryManager.hpp>
 #include <processes/definitions.hpp>
 
+namespace Kernel::ELF
+{
+	struct image_t;
+}
+
 namespace Kernel
 {
 	enum class ProcessState
@@ -37,6 +42,9 @@ namespace Kernel
 
 		Memory::memory_space_t &get_memory_space() { return m_memory_space; }
 
+		// Releases the previous images, which must not be mapped anymore. Statically linked executables have no loader image
+		void set_executable_image(ELF::image_t *image, ELF::image_t *loader_image);
+
 		thread_t *get_thread_by_index(size_t index) { return m_threads[index]; }
 
 		int add_file(FileContext &&file);
@@ -72,6 +80,8 @@ namespace Kernel
 		LibK::vector<FileContext> m_opened_files{};
 		LibK::vector<thread_t *> m_threads;
 		Memory::memory_space_t m_memory_space;
+		ELF::image_t *m_executable_image{nullptr};
+		ELF::image_t *m_loader_image{nullptr};
 		int8_t m_exit_code{0};
 		int8_t m_exit_signal{};
 		Process *m_parent{nullptr};
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <libk/GUID.hpp>
+
 #include <storage/StorageDevice.hpp>
 
 namespace Kernel::GPT
 {
+	// 0657FD6D-A4AB-43C4-84E5-0933C84B4F4F as it is stored on disk
+	static constexpr LibK::GUID LINUX_SWAP = LibK::GUID((const uint8_t[]){0x6D, 0xFD, 0x57, 0x06, 0xAB, 0xA4, 0xC4, 0x43, 0x84, 0xE5, 0x09, 0x33, 0xC8, 0x4B, 0x4F, 0x4F});
+
 	bool try_parse(StorageDevice &device);
 }
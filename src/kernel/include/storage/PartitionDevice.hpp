@@ -2,6 +2,8 @@
 
 #include <stddef.h>
 
+#include <libk/GUID.hpp>
+
 #include <storage/definitions.hpp>
 #include <devices/BlockDevice.hpp>
 
@@ -15,7 +17,7 @@ namespace Kernel
 		{
 		}
 
-		PartitionDevice(StorageDevice *device, size_t offset, size_t length);
+		PartitionDevice(StorageDevice *device, size_t offset, size_t length, const LibK::GUID &type);
 
 		size_t read(size_t, size_t, char *) override { return 0; };
 		size_t write(size_t, size_t, char *) override { return 0; };
@@ -29,6 +31,8 @@ namespace Kernel
 
 		LibK::StringView name() override { return LibK::StringView(m_name); }
 
+		[[nodiscard]] const LibK::GUID &type() const { return m_type; }
+
 	protected:
 		[[nodiscard]] bool can_open_for_read() const override { return true; };
 		[[nodiscard]] bool can_open_for_write() const override { return true; };
@@ -37,6 +41,7 @@ namespace Kernel
 		size_t m_offset{};
 		size_t m_length{};
 		StorageDevice *m_storage_device{nullptr};
+		LibK::GUID m_type{};
 		LibK::string m_name{};
 	};
 }
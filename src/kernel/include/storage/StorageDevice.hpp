@@ -43,7 +43,7 @@ namespace Kernel
 
 		LibK::StringView name() override { return LibK::StringView(m_name); }
 
-		void add_partition(size_t offset, size_t length) { m_partitions.emplace_back(this, offset, length); }
+		void add_partition(size_t offset, size_t length, const LibK::GUID &type) { m_partitions.emplace_back(this, offset, length, type); }
 
 		LibK::vector<PartitionDevice> &partitions() { return m_partitions; }
 
@@ -3,6 +3,7 @@
 #include <termios.h>
 #include <sys/syscall.h>
 #include <signal.h>
+#include <time.h>
 
 #include <sys/stat.h>
 
@@ -29,4 +30,6 @@ namespace Kernel
 	uintptr_t syscall$getdents(int fd, void *buffer, size_t count);
 	uintptr_t syscall$sigaction(int signal, const struct sigaction *act, struct sigaction *oact);
 	uintptr_t syscall$sigreturn(thread_registers_t *original_regs, CPU::interrupt_frame_t *frame);
+	uintptr_t syscall$clock_gettime(clockid_t clock_id, struct timespec *tp);
+	uintptr_t syscall$clock_nanosleep(clockid_t clock_id, int flags, const struct timespec *request, struct timespec *remain);
 }
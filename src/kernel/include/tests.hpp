@@ -6,4 +6,5 @@ namespace Kernel::Tests
 	bool test_crtx();
 	bool test_heap();
 	bool test_printf();
+	bool test_free_ranges();
 } // namespace Kernel::Tests
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+
+#include <stdint.h>
+
+#include <locking/Seqlock.hpp>
+
+namespace Kernel::Time
+{
+	// Monotonic nanoseconds since boot. Once calibrated the clock interpolates the TSC, which gives timestamps at the resolution of
+	// the TSC instead of the timer interrupts. Without an invariant TSC it stays on the time accounted by the timer interrupts of the BSP.
+	// The TSC is offset to continue where the timer interrupts left off, so switching over never makes the clock jump.
+	class Clock
+	{
+	public:
+		static Clock &instance()
+		{
+			static Clock *instance{nullptr};
+
+			if (!instance)
+				instance = new Clock();
+
+			return *instance;
+		}
+
+		Clock(Clock &) = delete;
+		void operator=(const Clock &) = delete;
+
+		// nanoseconds = ((tsc * scale) >> SCALE_SHIFT) + offset
+		static constexpr uint32_t SCALE_SHIFT = 22;
+
+		// Measures the TSC frequency against the PIT, which has to be registered with the EventManager, and reads the boot time from the RTC
+		void calibrate();
+
+		// Accounts time passed on the BSP timer, which is the clock until the TSC is calibrated
+		void tick(uint64_t nanoseconds);
+
+		[[nodiscard]] uint64_t now() const;
+
+		// Nanoseconds since the UNIX epoch, only as accurate as the second the RTC was read at
+		[[nodiscard]] uint64_t realtime() const { return m_boot_time + now(); }
+		[[nodiscard]] uint64_t boot_time() const { return m_boot_time; }
+
+		[[nodiscard]] uint64_t tick_time() const;
+		[[nodiscard]] uint64_t tsc_scale() const { return m_tsc_scale; }
+		[[nodiscard]] int64_t tsc_offset() const { return m_tsc_offset; }
+
+		[[nodiscard]] bool uses_tsc() const { return m_uses_tsc.load(std::memory_order_acquire); }
+		[[nodiscard]] bool is_tsc_invariant() const { return m_tsc_invariant; }
+		[[nodiscard]] uint64_t tsc_frequency() const { return m_tsc_frequency; }
+
+	private:
+		Clock() = default;
+		~Clock() = default;
+
+		static constexpr uint32_t CALIBRATION_MICROSECONDS = 20 * 1000;
+
+		void calibrate_tsc();
+
+		[[nodiscard]] uint64_t convert(uint64_t tsc) const;
+
+		std::atomic<bool> m_uses_tsc{false};
+		bool m_tsc_invariant{false};
+		uint64_t m_tsc_frequency{0};
+		uint64_t m_tsc_scale{0};
+		int64_t m_tsc_offset{0};
+
+		uint64_t m_boot_time{0};
+
+		uint64_t m_tick_time{0};
+		Locking::Seqlock m_tick_time_lock{};
+	};
+} // namespace Kernel::Time
@@ -3,11 +3,13 @@
 #include <atomic>
 #include <cstdint>
 
+#include <libk/kshared_ptr.hpp>
 #include <libk/kvector.hpp>
-#include <libk/Concurrent.hpp>
 
 #include <time/Timer.hpp>
+#include <time/TimerQueue.hpp>
 #include <arch/interrupts.hpp>
+#include <arch/spinlock.hpp>
 
 namespace Kernel::Time
 {
@@ -15,18 +17,43 @@ namespace Kernel::Time
 	constexpr uint64_t from_milliseconds(uint64_t milliseconds) { return milliseconds *= 1000000; }
 	constexpr uint64_t from_microseconds(uint64_t microseconds) { return microseconds *= 1000; }
 
-	// TODO: Prevent timer interrupts getting missed (specifically non core-local)
-	class EventManager
+	class EventManager;
+
+	// Refers to an event returned by EventManager::schedule_event, which can be cancelled or moved until it has fired.
+	// Cancelled events stay queued until their deadline passes, but their callback is skipped.
+	class TimerHandle
 	{
+	public:
+		TimerHandle() = default;
+
+		// Returns false if the event has already fired or was cancelled before
+		bool cancel();
+
+		// Cancels the event and schedules its callback again, core-local events move to the calling core
+		void reschedule(uint64_t nanoseconds);
+
+		[[nodiscard]] bool is_pending() const { return m_state && !m_state->done.load(std::memory_order_acquire); }
+
 	private:
-		typedef struct event_t
+		friend EventManager;
+
+		typedef struct state_t
 		{
+			std::atomic<bool> done;
 			LibK::function<void()> callback;
-			uint64_t nanoseconds;
 			bool core_local;
-			Timer *used_timer;
-		} event_t;
+		} state_t;
+
+		explicit TimerHandle(LibK::shared_ptr<state_t> state)
+		    : m_state(state)
+		{}
+
+		LibK::shared_ptr<state_t> m_state{};
+	};
 
+	// TODO: Prevent timer interrupts getting missed (specifically non core-local)
+	class EventManager
+	{
 	public:
 		static EventManager &instance()
 		{
@@ -40,6 +67,8 @@ namespace Kernel::Time
 
 		void register_timer(Timer *timer);
 
+		// Parks the current thread until the time has passed
+		void nanosleep(uint64_t nanoseconds);
 		void usleep(uint64_t usecs);
 		void sleep(uint64_t millis);
 
@@ -47,9 +76,10 @@ namespace Kernel::Time
 		// Used in BSP initialization as local timers are yet to be initialized.
 		void early_sleep(uint64_t usecs);
 
-		void schedule_event(const LibK::function<void()> &callback, uint64_t nanoseconds, bool core_sensitive);
+		TimerHandle schedule_event(const LibK::function<void()> &callback, uint64_t nanoseconds, bool core_sensitive);
 
-		typedef LibK::Concurrent<LibK::vector<event_t>> EventQueue;
+		// Core-local queues are only touched by their own core with interrupts disabled and need no lock
+		typedef TimerQueue EventQueue;
 
 	private:
 		EventManager() = default;
@@ -57,14 +87,17 @@ namespace Kernel::Time
 
 		void handle_event(Timer &timer);
 		uint64_t reduce_by(Timer &timer, uint64_t nanoseconds);
-		void schedule_next_event(LibK::vector<event_t> &event_queue);
 
-		void schedule_on(event_t &event, LibK::vector<event_t> &event_queue);
+		// Starts the fitting timer for the earliest event of the queue
+		void arm(EventQueue &event_queue, bool core_local);
 
-		void update_queue(LibK::vector<event_t> &event_queue, uint64_t nanoseconds);
+		EventQueue &queue_for(bool core_local);
+		void lock_queue(bool core_local);
+		void unlock_queue(bool core_local);
 
 		LibK::vector<Timer *> m_available_timers{};
 		std::atomic<uint32_t> m_sleeping{0}; // Bitmap of sleeping cores
-		EventQueue m_scheduled_events{}; // TODO: This should use some sort of linked list
+		EventQueue m_scheduled_events{};
+		Locking::Spinlock m_scheduled_events_lock{};
 	};
 }
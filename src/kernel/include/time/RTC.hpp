@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <arch/io.hpp>
+
+namespace Kernel::Time
+{
+	// Battery-backed wall clock in the CMOS, only read once at boot to find the time the system was started
+	class RTC
+	{
+	public:
+		static RTC &instance()
+		{
+			static RTC *instance{nullptr};
+
+			if (!instance)
+				instance = new RTC();
+
+			return *instance;
+		}
+
+		RTC(RTC &) = delete;
+		void operator=(const RTC &) = delete;
+
+		// Seconds since the UNIX epoch, the RTC is assumed to run on UTC
+		[[nodiscard]] uint64_t read_unix_time();
+
+	private:
+		typedef struct date_time_t
+		{
+			uint32_t second;
+			uint32_t minute;
+			uint32_t hour;
+			uint32_t day;
+			uint32_t month;
+			uint32_t year;
+		} date_time_t;
+
+		RTC() = default;
+		~RTC() = default;
+
+		[[nodiscard]] uint8_t read_register(uint8_t index);
+		[[nodiscard]] bool is_updating();
+		[[nodiscard]] date_time_t read_date_time();
+
+		IO::Port m_index{0x70};
+		IO::Port m_data{0x71};
+	};
+} // namespace Kernel::Time
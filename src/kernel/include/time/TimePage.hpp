@@ -0,0 +1,42 @@
+#pragma once
+
+#include <bits/time_page.h>
+
+#include <memory/definitions.hpp>
+
+namespace Kernel::Time
+{
+	// Publishes the state of the Clock on a page every process gets mapped read-only, so the libc can read the time without a syscall
+	class TimePage
+	{
+	public:
+		static TimePage &instance()
+		{
+			static TimePage *instance{nullptr};
+
+			if (!instance)
+				instance = new TimePage();
+
+			return *instance;
+		}
+
+		TimePage(TimePage &) = delete;
+		void operator=(const TimePage &) = delete;
+
+		// Allocates the page, the Clock has to be calibrated already
+		void initialize();
+
+		// Rewrites the page from the Clock, callers must not be interrupted by another update
+		void update();
+
+		// Maps the page read-only into the userspace of the current memory space
+		void map();
+
+	private:
+		TimePage() = default;
+		~TimePage() = default;
+
+		Memory::memory_region_t m_region{};
+		struct __time_page *m_page{nullptr};
+	};
+} // namespace Kernel::Time
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libk/kfunctional.hpp>
+#include <libk/kvector.hpp>
+
+#include <time/Timer.hpp>
+
+namespace Kernel::Time
+{
+	// Pending events in a binary min-heap ordered by their absolute deadline.
+	// The queue keeps its own notion of the current time, which only moves forward through advance(), so pending
+	// deadlines never have to be rewritten. Callbacks live in slots outside of the heap, so sifting only moves two words.
+	class TimerQueue
+	{
+	public:
+		// Returns true if the event became the earliest one and the queue has to be rearmed
+		bool insert(uint64_t nanoseconds, const LibK::function<void()> &callback);
+
+		// Takes the callback of the earliest event if it has expired, returns false otherwise
+		bool pop_expired(LibK::function<void()> &callback);
+
+		void advance(uint64_t nanoseconds) { m_now += nanoseconds; }
+
+		[[nodiscard]] bool empty() const { return m_heap.empty(); }
+		[[nodiscard]] uint64_t now() const { return m_now; }
+
+		// Time left until the earliest event expires, zero if it already has or if the queue is empty
+		[[nodiscard]] uint64_t time_to_next() const;
+
+		[[nodiscard]] Timer *armed_timer() const { return m_armed_timer; }
+		void set_armed_timer(Timer *timer) { m_armed_timer = timer; }
+
+	private:
+		typedef struct entry_t
+		{
+			uint64_t deadline;
+			uint32_t slot;
+		} entry_t;
+
+		[[nodiscard]] uint32_t allocate_slot(const LibK::function<void()> &callback);
+
+		// Returns the index the entry ended up at
+		size_t sift_up(size_t index);
+		void sift_down(size_t index);
+
+		uint64_t m_now{0};
+		Timer *m_armed_timer{nullptr};
+
+		LibK::vector<entry_t> m_heap{};
+		LibK::vector<LibK::function<void()>> m_callbacks{};
+		LibK::vector<uint32_t> m_free_slots{};
+	};
+} // namespace Kernel::Time
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <devices/KeyboardDevice.hpp>
+#include <locking/TicketLock.hpp>
 #include <tty/FramebufferConsole.hpp>
 #include <tty/TTY.hpp>
 #include <tty/Terminal.hpp>
@@ -67,6 +68,12 @@ namespace Kernel
 				return;
 			}
 
+			if (event.key == Key_L && (event.modifiers & (~CapsLock)) == (Pressed | Control | Alt))
+			{
+				Locking::TicketLock::dump_statistics();
+				return;
+			}
+
 			LibK::string result = parse_key_event(event);
 			for (auto ch : result)
 				emit(ch);
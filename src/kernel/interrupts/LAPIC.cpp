@@ -7,6 +7,7 @@
 #include <arch/smp.hpp>
 #include <interrupts/InterruptHandler.hpp>
 #include <memory/VirtualMemoryManager.hpp>
+#include <time/Clock.hpp>
 #include <time/EventManager.hpp>
 
 #include <logging/logger.hpp>
@@ -341,7 +342,7 @@ namespace Kernel::Interrupts
 		uint64_t next_interval;
 
 		if (core.id() == 0)
-			core.increment_nanoseconds_since_boot(elapsed_time * m_time_quantum);
+			Time::Clock::instance().tick(elapsed_time * m_time_quantum);
 
 		next_interval = m_reduce_callback(*this, elapsed_time * m_time_quantum);
 		next_interval /= m_time_quantum;
@@ -6,14 +6,8 @@ namespace Kernel::Locking
 {
 	bool Mutex::try_lock()
 	{
-		bool locked = m_lock.try_lock();
-
-		if (!locked)
-			return false;
-
-		m_locked.test_and_set();
-		m_lock.unlock();
-		return true;
+		// Never waits, the mutex is only taken if nobody holds it
+		return !m_locked.test_and_set(std::memory_order_acquire);
 	}
 
 	void Mutex::lock()
@@ -0,0 +1,77 @@
+#include <locking/RCU.hpp>
+
+#include <arch/Processor.hpp>
+
+namespace Kernel::Locking
+{
+	void RCU::read_lock()
+	{
+		CPU::Processor::current().enter_critical();
+	}
+
+	void RCU::read_unlock()
+	{
+		CPU::Processor::current().leave_critical();
+	}
+
+	void RCU::call(LibK::function<void()> &&callback)
+	{
+		// Cores that see the new epoch at a quiescent state have dropped every reference to the unlinked data
+		uint32_t epoch = m_epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+		m_lock.lock();
+		m_callbacks.push_back({.epoch = epoch, .function = std::move(callback)});
+		m_lock.unlock();
+	}
+
+	void RCU::quiescent_state()
+	{
+		m_core_epochs.local().store(m_epoch.load(std::memory_order_acquire), std::memory_order_release);
+
+		if (m_callbacks.empty())
+			return;
+
+		uint32_t completed = completed_epoch();
+		LibK::vector<LibK::function<void()>> ready;
+
+		m_lock.lock();
+
+		for (size_t i = 0; i < m_callbacks.size();)
+		{
+			// Epochs are compared by their distance, so they may wrap around
+			if (static_cast<int32_t>(completed - m_callbacks[i].epoch) < 0)
+			{
+				i++;
+				continue;
+			}
+
+			ready.push_back(std::move(m_callbacks[i].function));
+
+			if (i + 1 < m_callbacks.size())
+				m_callbacks[i] = std::move(m_callbacks.back());
+
+			m_callbacks.pop_back();
+		}
+
+		m_lock.unlock();
+
+		// The callbacks may take locks themselves
+		for (auto &callback : ready)
+			callback();
+	}
+
+	uint32_t RCU::completed_epoch() const
+	{
+		uint32_t completed = m_core_epochs.on(0).load(std::memory_order_acquire);
+
+		for (uint32_t id = 1; id < CPU::Processor::count(); id++)
+		{
+			uint32_t epoch = m_core_epochs.on(id).load(std::memory_order_acquire);
+
+			if (static_cast<int32_t>(epoch - completed) < 0)
+				completed = epoch;
+		}
+
+		return completed;
+	}
+} // namespace Kernel::Locking
@@ -0,0 +1,37 @@
+#include <locking/RWMutex.hpp>
+
+namespace Kernel::Locking
+{
+	void RWMutex::lock()
+	{
+		m_turnstile.lock();
+		m_resource.lock();
+	}
+
+	void RWMutex::unlock()
+	{
+		m_resource.unlock();
+		m_turnstile.unlock();
+	}
+
+	void RWMutex::lock_shared()
+	{
+		m_turnstile.lock();
+		m_turnstile.unlock();
+
+		// The first reader takes the resource for every reader after it
+		m_readers_lock.lock();
+		if (++m_readers == 1)
+			m_resource.lock();
+		m_readers_lock.unlock();
+	}
+
+	void RWMutex::unlock_shared()
+	{
+		m_readers_lock.lock();
+		assert(m_readers > 0);
+		if (--m_readers == 0)
+			m_resource.unlock();
+		m_readers_lock.unlock();
+	}
+} // namespace Kernel::Locking
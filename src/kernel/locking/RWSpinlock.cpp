@@ -0,0 +1,79 @@
+#include <locking/RWSpinlock.hpp>
+
+#include <arch/Processor.hpp>
+
+namespace Kernel::Locking
+{
+	void RWSpinlock::lock()
+	{
+		CPU::Processor::current().enter_critical();
+
+		while (true)
+		{
+			uint32_t state = m_state.load(std::memory_order_relaxed);
+
+			if ((state & ~WRITER_PENDING) == 0)
+			{
+				if (m_state.compare_exchange_weak(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed))
+					return;
+			}
+			else if (!(state & WRITER_PENDING))
+			{
+				m_state.fetch_or(WRITER_PENDING, std::memory_order_relaxed);
+			}
+
+			CPU::Processor::relax();
+		}
+	}
+
+	bool RWSpinlock::try_lock()
+	{
+		CPU::Processor::current().enter_critical();
+
+		// Waiting writers are not overtaken
+		uint32_t state = 0;
+		bool lock_succeeded = m_state.compare_exchange_strong(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+
+		if (!lock_succeeded)
+			CPU::Processor::current().leave_critical();
+
+		return lock_succeeded;
+	}
+
+	void RWSpinlock::unlock()
+	{
+		assert(is_locked());
+
+		// Keep the pending bit of other writers that are waiting
+		m_state.fetch_and(~WRITER, std::memory_order_release);
+		CPU::Processor::current().leave_critical();
+	}
+
+	void RWSpinlock::lock_shared()
+	{
+		CPU::Processor::current().enter_critical();
+
+		while (true)
+		{
+			uint32_t state = m_state.load(std::memory_order_relaxed);
+
+			if (!(state & (WRITER | WRITER_PENDING)))
+			{
+				assert((state & READER_MASK) != READER_MASK);
+
+				if (m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed))
+					return;
+			}
+
+			CPU::Processor::relax();
+		}
+	}
+
+	void RWSpinlock::unlock_shared()
+	{
+		assert(is_locked_shared());
+
+		m_state.fetch_sub(1, std::memory_order_release);
+		CPU::Processor::current().leave_critical();
+	}
+} // namespace Kernel::Locking
@@ -0,0 +1,36 @@
+#include <locking/Seqlock.hpp>
+
+#include <arch/Processor.hpp>
+
+namespace Kernel::Locking
+{
+	uint32_t Seqlock::read_begin() const
+	{
+		uint32_t sequence;
+
+		// An odd sequence means a writer is active
+		while ((sequence = m_sequence.load(std::memory_order_acquire)) & 1)
+			CPU::Processor::pause();
+
+		return sequence;
+	}
+
+	bool Seqlock::read_retry(uint32_t sequence) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_sequence.load(std::memory_order_relaxed) != sequence;
+	}
+
+	void Seqlock::write_lock()
+	{
+		m_lock.lock();
+		m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void Seqlock::write_unlock()
+	{
+		m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		m_lock.unlock();
+	}
+} // namespace Kernel::Locking
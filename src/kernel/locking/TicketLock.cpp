@@ -0,0 +1,88 @@
+#include <locking/TicketLock.hpp>
+
+#include <arch/Processor.hpp>
+#include <logging/logger.hpp>
+
+#include <libk/kmath.hpp>
+
+namespace Kernel::Locking
+{
+	std::atomic<TicketLock *> TicketLock::s_named_locks{nullptr};
+
+	TicketLock::TicketLock(const char *name)
+	    : m_name(name)
+	{
+		m_next_named = s_named_locks.load(std::memory_order_relaxed);
+		while (!s_named_locks.compare_exchange_weak(m_next_named, this, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	bool TicketLock::try_lock()
+	{
+		CPU::Processor::current().enter_critical();
+
+		// The lock is free if nobody has drawn a ticket past the one that is served
+		uint16_t ticket = m_now_serving.load(std::memory_order_relaxed);
+		bool lock_succeeded = m_next_ticket.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed);
+
+		if (!lock_succeeded)
+		{
+			CPU::Processor::current().leave_critical();
+			return false;
+		}
+
+		acquired(0);
+
+		return true;
+	}
+
+	void TicketLock::lock()
+	{
+		CPU::Processor::current().enter_critical();
+
+		uint16_t ticket = m_next_ticket.fetch_add(1, std::memory_order_relaxed);
+		uint32_t spins = 0;
+
+		while (m_now_serving.load(std::memory_order_acquire) != ticket)
+		{
+			CPU::Processor::relax();
+			spins++;
+		}
+
+		acquired(spins);
+	}
+
+	void TicketLock::unlock()
+	{
+		assert(is_locked());
+
+		if (m_name)
+			m_statistics.max_hold_time = LibK::max(m_statistics.max_hold_time, CPU::Processor::read_tsc() - m_statistics.acquired_at);
+
+		m_now_serving.store(m_now_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		CPU::Processor::current().leave_critical();
+	}
+
+	void TicketLock::dump_statistics()
+	{
+		for (auto *lock = s_named_locks.load(std::memory_order_acquire); lock; lock = lock->m_next_named)
+		{
+			// Reading without the lock may give slightly inconsistent numbers, which is good enough for a dump
+			auto &statistics = lock->m_statistics;
+			log("LOCKS", "%s: %u acquisitions, %u contended, %llu spins, %llu ticks max hold time", lock->m_name, statistics.acquisitions, statistics.contentions, statistics.spins, statistics.max_hold_time);
+		}
+	}
+
+	void TicketLock::acquired(uint32_t spins)
+	{
+		if (!m_name)
+			return;
+
+		m_statistics.acquisitions++;
+		m_statistics.spins += spins;
+		m_statistics.acquired_at = CPU::Processor::read_tsc();
+
+		if (spins > 0)
+			m_statistics.contentions++;
+	}
+} // namespace Kernel::Locking
@@ -0,0 +1,100 @@
+#include <memory/FreeRangeIndex.hpp>
+
+namespace Kernel::Memory
+{
+	region_t FreeRangeIndex::find_best_fit(size_t size) const
+	{
+		auto *best_fit = m_by_size.lower_bound({.range = {.address = 0, .size = size}});
+
+		if (!best_fit)
+			return {0, 0};
+
+		return best_fit->range;
+	}
+
+	void FreeRangeIndex::reserve(const region_t &range)
+	{
+		if (range.size == 0)
+			return;
+
+		while (true)
+		{
+			auto *overlapping = m_by_address.find([&range](region_t free_range) {
+				if (free_range.overlaps(range))
+					return 0;
+				else if (free_range.address < range.address)
+					return -1;
+				else
+					return 1;
+			});
+
+			if (!overlapping)
+				return;
+
+			region_t free_range = *overlapping;
+			remove(free_range);
+
+			if (free_range.address < range.address)
+				insert({free_range.address, range.address - free_range.address});
+
+			if (free_range.end() > range.end())
+				insert({range.end() + 1, free_range.end() - range.end()});
+		}
+	}
+
+	void FreeRangeIndex::release(const region_t &range)
+	{
+		if (range.size == 0)
+			return;
+
+		region_t merged = range;
+
+		if (range.address > 0)
+		{
+			auto *left = m_by_address.find([&range](region_t free_range) {
+				if (free_range.contains(range.address - 1))
+					return 0;
+				else if (free_range.address < range.address - 1)
+					return -1;
+				else
+					return 1;
+			});
+
+			if (left)
+			{
+				region_t left_range = *left;
+				remove(left_range);
+
+				merged.address = left_range.address;
+				merged.size += left_range.size;
+			}
+		}
+
+		if (range.end() != UINTPTR_MAX)
+		{
+			auto *right = m_by_address.find(region_t{range.end() + 1, 0});
+
+			if (right)
+			{
+				region_t right_range = *right;
+				remove(right_range);
+
+				merged.size += right_range.size;
+			}
+		}
+
+		insert(merged);
+	}
+
+	void FreeRangeIndex::insert(const region_t &range)
+	{
+		m_by_address.insert(range);
+		m_by_size.insert({.range = range});
+	}
+
+	void FreeRangeIndex::remove(const region_t &range)
+	{
+		m_by_address.remove(range);
+		m_by_size.remove({.range = range});
+	}
+} // namespace Kernel::Memory
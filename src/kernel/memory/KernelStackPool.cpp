@@ -0,0 +1,57 @@
+#include <memory/KernelStackPool.hpp>
+
+#include <arch/memory.hpp>
+#include <memory/PhysicalMemoryManager.hpp>
+#include <memory/VirtualMemoryManager.hpp>
+#include <processes/definitions.hpp>
+
+#include <libk/kcassert.hpp>
+
+namespace Kernel::Memory
+{
+	memory_region_t KernelStackPool::allocate()
+	{
+		m_lock.lock();
+
+		if (!m_free_stacks.empty())
+		{
+			memory_region_t stack = m_free_stacks.back();
+			m_free_stacks.pop_back();
+
+			m_lock.unlock();
+
+			return stack;
+		}
+
+		m_lock.unlock();
+
+		return create_stack();
+	}
+
+	void KernelStackPool::release(const memory_region_t &stack)
+	{
+		assert(stack.size == KERNEL_STACK_SIZE);
+
+		m_lock.lock();
+		m_free_stacks.push_back(stack);
+		m_lock.unlock();
+	}
+
+	memory_region_t KernelStackPool::create_stack()
+	{
+		auto region = VirtualMemoryManager::instance().allocate_region(PAGE_SIZE + KERNEL_STACK_SIZE);
+		assert(region.virt_address);
+
+		// The region stays in the kernel map, so nothing else gets placed at the guard page once it is unmapped
+		auto paging_space = Arch::get_kernel_paging_space();
+		Arch::unmap(paging_space, region.virt_address, PAGE_SIZE);
+		PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(region.phys_address), PAGE_SIZE);
+
+		memory_region_t stack = region;
+		stack.virt_address += PAGE_SIZE;
+		stack.phys_address += PAGE_SIZE;
+		stack.size = KERNEL_STACK_SIZE;
+
+		return stack;
+	}
+} // namespace Kernel::Memory
@@ -2,6 +2,8 @@
 
 #include <arch/memory.hpp>
 #include <arch/Processor.hpp>
+#include <memory/ShrinkerRegistry.hpp>
+#include <memory/SwapManager.hpp>
 #include <panic.hpp>
 
 #include <libk/kcassert.hpp>
@@ -44,7 +46,6 @@ namespace Kernel::Memory
 			m_buddies[i] = {
 			    .page_size = page_size,
 			    .page_count = page_count,
-			    .last_alloc = 0,
 			    .bitmap = bitmap,
 			};
 
@@ -75,6 +76,10 @@ namespace Kernel::Memory
 
 			m_used_memory += (end - start + 1) * PAGE_SIZE;
 		}
+
+		uintptr_t memory_end = m_memory_map.get_usable_mem_size();
+		init_zone(Zone::DMA, 0, LibK::min<uintptr_t>(memory_end, DMA_ZONE_END));
+		init_zone(Zone::Normal, DMA_ZONE_END, memory_end);
 	}
 
 	void PhysicalMemoryManager::set_bit(size_t bit, uint32_t *bitmap)
@@ -185,18 +190,90 @@ namespace Kernel::Memory
 		return LibK::size(m_buddies) - 1;
 	}
 
+	void PhysicalMemoryManager::init_zone(Zone type, uintptr_t start_address, uintptr_t end_address)
+	{
+		auto &zone = m_zones[static_cast<size_t>(type)];
+
+		zone = {
+		    .type = type,
+		    .node = 0,
+		    .start_page = start_address / PAGE_SIZE,
+		    .end_page = LibK::max(start_address, end_address) / PAGE_SIZE,
+		    .free_pages = 0,
+		    .watermark = 0,
+		    .last_alloc = {},
+		};
+
+		for (size_t i = zone.start_page; i < zone.end_page; i++)
+		{
+			if (!get_bit(i, m_buddies[0].bitmap))
+				zone.free_pages++;
+		}
+
+		zone.watermark = zone.free_pages / ZONE_WATERMARK_RATIO;
+
+		for (size_t i = 0; i < BUDDY_COUNT; i++)
+			zone.last_alloc[i] = zone.start_page >> i;
+	}
+
+	PhysicalMemoryManager::zone_t &PhysicalMemoryManager::get_zone(size_t page_idx)
+	{
+		for (auto &zone : m_zones)
+		{
+			if (page_idx < zone.end_page)
+				return zone;
+		}
+
+		return m_zones[ZONE_COUNT - 1];
+	}
+
 	void *PhysicalMemoryManager::alloc(size_t size, uint32_t min_address, uint32_t max_address, uint32_t boundary)
+	{
+		size_t needed_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+		size_t min_page = (min_address + PAGE_SIZE - 1) / PAGE_SIZE;
+		size_t max_page = max_address / PAGE_SIZE;
+		bool is_fallback = false;
+
+		// Start with the highest zone that satisfies the constraints, lower zones are kept for allocations that need them
+		for (size_t i = ZONE_COUNT; i-- > 0;)
+		{
+			auto &zone = m_zones[i];
+
+			if (zone.start_page >= zone.end_page || zone.start_page > max_page || zone.end_page <= min_page)
+				continue;
+
+			if (is_fallback && zone.free_pages < needed_pages + zone.watermark)
+				continue;
+
+			void *page = alloc_from(zone, size, min_address, max_address, boundary);
+			if (page)
+				return page;
+
+			is_fallback = true;
+		}
+
+		// Drop cached data first and evict pages to swap afterwards, only fail once neither frees anything
+		if (ShrinkerRegistry::instance().shrink(needed_pages) > 0 || SwapManager::instance().page_out(needed_pages) > 0)
+			return alloc(size, min_address, max_address, boundary);
+
+		panic("Out Of Memory (OOM) while allocating physical buffer of size %d", size);
+	}
+
+	void *PhysicalMemoryManager::alloc_from(zone_t &zone, size_t size, uint32_t min_address, uint32_t max_address, uint32_t boundary)
 	{
 		size_t idx = get_buddy(size);
 		auto &buddy = m_buddies[idx];
 
 		size_t needed_page_count = (size + buddy.page_size - 1) / buddy.page_size;
 
-		size_t start = (min_address + buddy.page_size - 1) / buddy.page_size;
+		size_t start = LibK::max((min_address + buddy.page_size - 1) / buddy.page_size, zone.start_page >> idx);
 		uint32_t real_max_address = LibK::min<uint32_t>(max_address, m_memory_map.get_usable_mem_size());
-		size_t end = real_max_address / buddy.page_size;
+		size_t end = LibK::min(real_max_address / buddy.page_size, zone.end_page >> idx);
+
+		if (start >= end)
+			return nullptr;
 
-		size_t idx_start = LibK::max(buddy.last_alloc, start);
+		size_t idx_start = LibK::max(zone.last_alloc[idx], start);
 
 		for (size_t i = idx_start + 1; i != idx_start; i++)
 		{
@@ -216,7 +293,7 @@ namespace Kernel::Memory
 			m_lock.lock();
 
 			size_t count = 0;
-			for (; i + count < buddy.page_count && count < needed_page_count && !get_bit(i, buddy.bitmap); count++)
+			for (; i + count < end && count < needed_page_count && !get_bit(i + count, buddy.bitmap); count++)
 				;
 
 			if (count < needed_page_count)
@@ -232,10 +309,11 @@ namespace Kernel::Memory
 
 			m_used_memory += needed_small_page_count * PAGE_SIZE;
 			m_explicit_used_memory += size;
+			zone.free_pages -= needed_small_page_count;
 
-			for (auto &other_buddy : m_buddies)
+			for (auto &last_alloc : zone.last_alloc)
 			{
-				other_buddy.last_alloc = small_page_idx + needed_small_page_count - 1;
+				last_alloc = small_page_idx + needed_small_page_count - 1;
 				small_page_idx /= 2;
 				needed_small_page_count /= 2;
 			}
@@ -245,19 +323,18 @@ namespace Kernel::Memory
 			return (void *)phys_addr;
 		}
 
-		// TODO: Alert VMM to free up some memory (e.g. free cached objects, swap memory)
-		panic("Out Of Memory (OOM) while allocating physical buffer of size %d", size);
+		return nullptr;
 	}
 
 	void PhysicalMemoryManager::free(void *page, size_t size)
 	{
 		size_t page_idx = (uintptr_t)(page) / PAGE_SIZE;
-		auto &buddy = m_buddies[get_buddy(size)];
-		size_t page_count = (size + buddy.page_size - 1) / PAGE_SIZE;
+		size_t page_count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
 
 		m_lock.lock();
 
 		mark_free(page_idx, page_idx + page_count - 1);
+		get_zone(page_idx).free_pages += page_count;
 
 		m_lock.unlock();
 
@@ -274,6 +351,9 @@ namespace Kernel::Memory
 
 		mark_used(start_page, start_page + page_count);
 
+		auto &zone = get_zone(start_page);
+		zone.free_pages -= LibK::min(zone.free_pages, page_count);
+
 		m_lock.unlock();
 
 		m_used_memory += page_count * PAGE_SIZE;
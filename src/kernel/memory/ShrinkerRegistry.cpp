@@ -0,0 +1,37 @@
+#include <memory/ShrinkerRegistry.hpp>
+
+#include <arch/Processor.hpp>
+
+namespace Kernel::Memory
+{
+	void ShrinkerRegistry::register_shrinker(shrinker_t &&shrinker)
+	{
+		m_lock.lock();
+		m_owner.store(CPU::Processor::current().id(), std::memory_order_relaxed);
+
+		m_shrinkers.push_back(std::move(shrinker));
+
+		m_owner.store(NO_OWNER, std::memory_order_relaxed);
+		m_lock.unlock();
+	}
+
+	size_t ShrinkerRegistry::shrink(size_t page_count)
+	{
+		uint32_t core_id = CPU::Processor::current().id();
+		if (m_owner.load(std::memory_order_relaxed) == core_id)
+			return 0;
+
+		m_lock.lock();
+		m_owner.store(core_id, std::memory_order_relaxed);
+
+		size_t freed = 0;
+
+		for (size_t i = 0; i < m_shrinkers.size() && freed < page_count; i++)
+			freed += m_shrinkers[i](page_count - freed);
+
+		m_owner.store(NO_OWNER, std::memory_order_relaxed);
+		m_lock.unlock();
+
+		return freed;
+	}
+} // namespace Kernel::Memory
@@ -0,0 +1,354 @@
+#include <memory/SwapManager.hpp>
+
+#include <arch/Processor.hpp>
+#include <arch/memory.hpp>
+#include <logging/logger.hpp>
+#include <memory/PhysicalMemoryManager.hpp>
+#include <panic.hpp>
+#include <storage/GPT.hpp>
+#include <storage/ata/AHCIManager.hpp>
+
+#include <libk/kcassert.hpp>
+#include <libk/kcmalloc.hpp>
+#include <libk/kmath.hpp>
+
+namespace Kernel::Memory
+{
+	void SwapManager::init()
+	{
+		for (auto &device : AHCIManager::instance().devices())
+		{
+			for (auto &partition : device.partitions())
+			{
+				if (partition.type() == GPT::LINUX_SWAP)
+				{
+					m_partition = &partition;
+					break;
+				}
+			}
+
+			if (m_partition)
+				break;
+		}
+
+		if (!m_partition)
+		{
+			log("SWAP", "No swap partition found");
+			return;
+		}
+
+		m_blocks_per_slot = PAGE_SIZE / m_partition->block_size();
+
+		// The first page holds the signature of the partition
+		size_t page_count = m_partition->size() / m_blocks_per_slot;
+		m_slot_count = LibK::min<size_t>(page_count > 0 ? page_count - 1 : 0, SWAP_SLOT_LIMIT);
+
+		m_slot_bitmap = static_cast<uint32_t *>(kcalloc(LibK::ceil_div<size_t>(m_slot_count, 32) * sizeof(uint32_t)));
+		assert(m_slot_bitmap);
+
+		m_buffer = VirtualMemoryManager::instance().allocate_region(PAGE_SIZE);
+
+		log("SWAP", "Using %u KiB of swap space", m_slot_count * (PAGE_SIZE / 1024));
+	}
+
+	void SwapManager::add_memory_space(memory_space_t *memory_space)
+	{
+		m_lock.lock();
+		m_memory_spaces.push_back(memory_space);
+		m_lock.unlock();
+	}
+
+	void SwapManager::remove_memory_space(memory_space_t *memory_space)
+	{
+		// Without a swap partition there are no victims that could still point at the space
+		if (is_available())
+			lock_io();
+
+		m_lock.lock();
+
+		for (auto it = m_memory_spaces.begin(); it != m_memory_spaces.end(); ++it)
+		{
+			if (*it == memory_space)
+			{
+				m_memory_spaces.erase(it);
+				break;
+			}
+		}
+
+		m_lock.unlock();
+
+		if (is_available())
+			unlock_io();
+	}
+
+	size_t SwapManager::page_out(size_t page_count)
+	{
+		if (!is_available() || !CPU::Processor::current().can_block())
+			return 0;
+
+		if (m_io_owner.load(std::memory_order_relaxed) == CPU::Processor::current().get_current_thread())
+			return 0;
+
+		lock_io();
+
+		size_t freed = 0;
+		bool has_failed = false;
+
+		while (freed < page_count && !has_failed)
+		{
+			size_t count = select_victims(LibK::min(page_count - freed, BALANCE_BATCH));
+			if (count == 0)
+				break;
+
+			// Every selected victim has to be written or put back, even after a failure
+			for (size_t i = 0; i < count; i++)
+			{
+				if (write_victim(m_victims[i]))
+					freed++;
+				else
+					has_failed = true;
+			}
+		}
+
+		unlock_io();
+
+		return freed;
+	}
+
+	void SwapManager::balance()
+	{
+		if (!is_available() || PhysicalMemoryManager::instance().get_free_memory() >= LOW_FREE_MEMORY)
+			return;
+
+		page_out(BALANCE_BATCH);
+	}
+
+	bool SwapManager::swap_in(memory_space_t *memory_space, uintptr_t virt_address, mapping_config_t config)
+	{
+		if (!CPU::Processor::current().can_block())
+			panic("Swapped out page %p touched while the core cannot block", virt_address);
+
+		// Taken before the io lock, as allocating may have to page out, which needs the io lock itself
+		uintptr_t phys_address = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(PAGE_SIZE, config.bounds.address, config.bounds.end()));
+
+		lock_io();
+
+		size_t slot;
+		bool is_swapped = read_page(memory_space, virt_address, phys_address, slot);
+
+		if (is_swapped)
+		{
+			// Nobody else swaps pages in or out meanwhile, but the page may have been unmapped during the transfer
+			size_t current_slot;
+			memory_space->lock->lock();
+
+			is_swapped = Arch::get_swap_entry(memory_space->paging_space, virt_address, current_slot) && current_slot == slot;
+			if (is_swapped)
+				Arch::map(memory_space->paging_space, phys_address, virt_address, PAGE_SIZE, config);
+
+			memory_space->lock->unlock();
+		}
+
+		if (is_swapped)
+			release(slot);
+		else
+			PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(phys_address), PAGE_SIZE);
+
+		unlock_io();
+
+		return is_swapped;
+	}
+
+	bool SwapManager::read(memory_space_t *memory_space, uintptr_t virt_address, uintptr_t phys_address)
+	{
+		assert(CPU::Processor::current().can_block());
+
+		lock_io();
+
+		size_t slot;
+		bool is_swapped = read_page(memory_space, virt_address, phys_address, slot);
+
+		unlock_io();
+
+		return is_swapped;
+	}
+
+	void SwapManager::release(size_t slot)
+	{
+		m_lock.lock();
+		free_slot(slot);
+		m_lock.unlock();
+	}
+
+	void SwapManager::lock_io()
+	{
+		m_io_lock.lock();
+		m_io_owner.store(CPU::Processor::current().get_current_thread(), std::memory_order_relaxed);
+	}
+
+	void SwapManager::unlock_io()
+	{
+		m_io_owner.store(nullptr, std::memory_order_relaxed);
+		m_io_lock.unlock();
+	}
+
+	size_t SwapManager::select_victims(size_t limit)
+	{
+		m_lock.lock();
+
+		size_t count = 0;
+
+		// The first pass clears the accessed flags, so pages that are still untouched by the second pass get evicted
+		for (size_t pass = 0; pass < 2 && count < limit; pass++)
+		{
+			for (size_t i = 0; i < m_memory_spaces.size() && count < limit; i++)
+			{
+				auto *memory_space = m_memory_spaces[(m_next_memory_space + i) % m_memory_spaces.size()];
+
+				// Spaces that are being modified are left alone, their lock is taken after m_lock everywhere else
+				if (!memory_space->lock->try_lock())
+					continue;
+
+				count += select_victims_from(*memory_space, m_victims + count, limit - count);
+
+				memory_space->lock->unlock();
+			}
+		}
+
+		// Spread the evictions over all memory spaces
+		m_next_memory_space++;
+
+		m_lock.unlock();
+
+		return count;
+	}
+
+	bool SwapManager::write_victim(const victim_t &victim)
+	{
+		// The frame is unmapped everywhere, so it can be read without holding any lock
+		Arch::copy_from_page(m_buffer.virt_region().pointer(), victim.phys_address);
+
+		if (transfer(victim.slot, true))
+		{
+			PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(victim.phys_address), PAGE_SIZE);
+			return true;
+		}
+
+		log("SWAP", "Failed to write swap slot %u", victim.slot);
+
+		// Put the page back, unless it has been unmapped during the transfer, which released the slot already
+		size_t slot;
+		victim.memory_space->lock->lock();
+
+		bool is_swapped = Arch::get_swap_entry(victim.memory_space->paging_space, victim.virt_address, slot) && slot == victim.slot;
+		if (is_swapped)
+			Arch::map(victim.memory_space->paging_space, victim.phys_address, victim.virt_address, PAGE_SIZE, victim.config);
+
+		victim.memory_space->lock->unlock();
+
+		if (is_swapped)
+			release(victim.slot);
+		else
+			PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(victim.phys_address), PAGE_SIZE);
+
+		return false;
+	}
+
+	bool SwapManager::read_page(memory_space_t *memory_space, uintptr_t virt_address, uintptr_t phys_address, size_t &slot)
+	{
+		memory_space->lock->lock_shared();
+		bool is_swapped = Arch::get_swap_entry(memory_space->paging_space, virt_address, slot);
+		memory_space->lock->unlock_shared();
+
+		if (!is_swapped)
+			return false;
+
+		if (!transfer(slot, false))
+			panic("Failed to read swap slot %u", slot);
+
+		Arch::copy_page(phys_address, m_buffer.virt_region().pointer());
+
+		return true;
+	}
+
+	size_t SwapManager::select_victims_from(memory_space_t &memory_space, victim_t *victims, size_t limit)
+	{
+		size_t count = 0;
+		bool is_full = false;
+
+		memory_space.userland_map.traverse([&](memory_region_t region) {
+			// Only reserved memory is backed page by page, shared pages and pages with physical constraints stay where they are
+			bool is_unbounded = region.config.bounds.address == 0 && region.config.bounds.size == SIZE_MAX;
+			if (region.present || !region.config.userspace || region.config.shared || !is_unbounded)
+				return true;
+
+			for (uintptr_t page = region.virt_address; page < region.virt_address + region.size && count < limit; page += PAGE_SIZE)
+			{
+				if (!Arch::is_mapped(memory_space.paging_space, page) || Arch::test_and_clear_accessed(memory_space.paging_space, page))
+					continue;
+
+				size_t slot = allocate_slot();
+				if (slot == NO_SLOT)
+				{
+					is_full = true;
+					break;
+				}
+
+				// Unmap the page first and wait for every core to drop it from its TLB, so no other thread writes to it while it is transferred.
+				// A fault on the page meanwhile waits for the io lock, which is only released once the page has been written
+				victims[count++] = victim_t{
+				    .memory_space = &memory_space,
+				    .virt_address = page,
+				    .phys_address = Arch::set_swap_entry(memory_space.paging_space, page, slot),
+				    .slot = slot,
+				    .config = region.config,
+				};
+			}
+
+			return !is_full && count < limit;
+		});
+
+		return count;
+	}
+
+	size_t SwapManager::allocate_slot()
+	{
+		if (m_used_slots == m_slot_count)
+			return NO_SLOT;
+
+		for (size_t i = 0; i < m_slot_count; i++)
+		{
+			size_t slot = (m_next_slot + i) % m_slot_count;
+
+			if (m_slot_bitmap[slot / 32] & (1 << (slot % 32)))
+				continue;
+
+			m_slot_bitmap[slot / 32] |= 1 << (slot % 32);
+			m_used_slots++;
+			m_next_slot = slot + 1;
+
+			return slot;
+		}
+
+		return NO_SLOT;
+	}
+
+	void SwapManager::free_slot(size_t slot)
+	{
+		assert(slot < m_slot_count);
+		assert(m_slot_bitmap[slot / 32] & (1 << (slot % 32)));
+
+		m_slot_bitmap[slot / 32] &= ~(1 << (slot % 32));
+		m_used_slots--;
+	}
+
+	bool SwapManager::transfer(size_t slot, bool is_write)
+	{
+		size_t block = (slot + 1) * m_blocks_per_slot;
+		auto *buffer = static_cast<char *>(m_buffer.virt_region().pointer());
+
+		size_t transferred = is_write ? m_partition->write_blocks(block, m_blocks_per_slot, buffer) : m_partition->read_blocks(block, m_blocks_per_slot, buffer);
+
+		return transferred == PAGE_SIZE;
+	}
+} // namespace Kernel::Memory
@@ -2,6 +2,9 @@
 
 #include <common_attributes.h>
 #include <memory/PhysicalMemoryManager.hpp>
+#include <memory/ShrinkerRegistry.hpp>
+#include <memory/SwapManager.hpp>
+#include <memory/ZeroPagePool.hpp>
 #include <panic.hpp>
 #include <arch/Processor.hpp>
 
@@ -24,6 +27,7 @@ namespace Kernel::Memory
 
 		m_kernel_paging_space = Arch::create_kernel_space();
 		Arch::load(m_kernel_paging_space);
+		Arch::preallocate_kernel_page_tables();
 
 		auto kernel_region = Arch::get_kernel_region();
 		auto mapping_region = Arch::get_mapping_region();
@@ -31,12 +35,27 @@ namespace Kernel::Memory
 		m_kernel_memory_map.insert(kernel_region);
 		m_kernel_memory_map.insert(mapping_region);
 
+		m_kernel_free_ranges = FreeRangeIndex(get_kernel_space_range());
+		m_kernel_free_ranges.reserve(kernel_region.virt_region());
+		m_kernel_free_ranges.reserve(mapping_region.virt_region());
+
 		m_kernel_memory_space = {
 		    .paging_space = m_kernel_paging_space,
 		    .userland_map = {},
+		    .userland_free_ranges = FreeRangeIndex(get_userland_range()),
+		    .lock = LibK::shared_ptr<Locking::RWSpinlock>(new Locking::RWSpinlock()),
 		};
 
 		CPU::Processor::current().set_memory_space(&m_kernel_memory_space);
+
+		// Construct the pool while only the BSP is running, as every idle thread fills it up
+		(void)ZeroPagePool::instance();
+	}
+
+	void VirtualMemoryManager::init_ap()
+	{
+		Arch::initialize();
+		CPU::Processor::current().set_memory_space(&m_kernel_memory_space);
 	}
 
 	memory_region_t VirtualMemoryManager::allocate_region(size_t size, mapping_config_t config)
@@ -48,14 +67,13 @@ namespace Kernel::Memory
 
 		uintptr_t phys_addr = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(size, config.bounds.address, config.bounds.end(), config.alignment));
 
-		if (is_kernel_space)
-			m_lock.lock();
+		auto &lock = get_lock(memory_space, is_kernel_space);
+		lock.lock();
 
-		region_t region = find_free_region(memory_space, size, is_kernel_space);
-		auto mapping = map(memory_space, phys_addr, region.address, size, config);
+		uintptr_t virt_addr = find_free_address(memory_space, phys_addr, size, config);
+		auto mapping = map(memory_space, phys_addr, virt_addr, size, config);
 
-		if (is_kernel_space)
-			m_lock.unlock();
+		lock.unlock();
 
 		return mapping;
 	}
@@ -74,22 +92,143 @@ namespace Kernel::Memory
 
 		uintptr_t phys_addr = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(size, config.bounds.address, config.bounds.end(), config.alignment));
 
-		bool is_kernel_space = in_kernel_space(virt_addr);
+		auto &lock = get_lock(memory_space, in_kernel_space(virt_addr));
+		lock.lock();
 
-		if (find_region(memory_space, virt_addr))
+		if (lookup(memory_space, virt_addr))
+		{
+			lock.unlock();
+			PhysicalMemoryManager::instance().free((void *)phys_addr, size);
 			return {};
-
-		if (is_kernel_space)
-			m_lock.lock();
+		}
 
 		auto mapping = map(memory_space, phys_addr, virt_addr, size, config);
 
-		if (is_kernel_space)
-			m_lock.unlock();
+		lock.unlock();
 
 		return mapping;
 	}
 
+	memory_region_t VirtualMemoryManager::reserve_region(size_t size, mapping_config_t config)
+	{
+		auto memory_space = CPU::Processor::current().get_memory_space();
+		size = LibK::round_up_to_multiple<size_t>(size, PAGE_SIZE);
+
+		bool is_kernel_space = !config.userspace;
+
+		auto &lock = get_lock(memory_space, is_kernel_space);
+		lock.lock();
+
+		region_t region = find_free_region(memory_space, size, is_kernel_space);
+		auto reservation = reserve(memory_space, region.address, size, config);
+
+		lock.unlock();
+
+		return reservation;
+	}
+
+	memory_region_t VirtualMemoryManager::reserve_region_at_for(memory_space_t *memory_space, uintptr_t virt_addr, size_t size, mapping_config_t config)
+	{
+		uintptr_t address = LibK::round_down_to_multiple<uintptr_t>(virt_addr, PAGE_SIZE);
+		size = LibK::round_up_to_multiple<size_t>(size + (virt_addr - address), PAGE_SIZE);
+		virt_addr = address;
+
+		auto &lock = get_lock(memory_space, in_kernel_space(virt_addr));
+		lock.lock();
+
+		if (lookup(memory_space, virt_addr))
+		{
+			lock.unlock();
+			return {};
+		}
+
+		auto reservation = reserve(memory_space, virt_addr, size, config);
+
+		lock.unlock();
+
+		return reservation;
+	}
+
+	memory_region_t VirtualMemoryManager::share_region_at(uintptr_t phys_addr, uintptr_t virt_addr, size_t size, mapping_config_t config)
+	{
+		auto memory_space = CPU::Processor::current().get_memory_space();
+
+		assert(phys_addr % PAGE_SIZE == 0 && virt_addr % PAGE_SIZE == 0);
+		size = LibK::round_up_to_multiple<size_t>(size, PAGE_SIZE);
+		config.shared = true;
+
+		auto &lock = get_lock(memory_space, in_kernel_space(virt_addr));
+		lock.lock();
+
+		if (lookup(memory_space, virt_addr))
+		{
+			lock.unlock();
+			return {};
+		}
+
+		auto mapping = share(memory_space, phys_addr, virt_addr, size, config);
+
+		lock.unlock();
+
+		return mapping;
+	}
+
+	bool VirtualMemoryManager::handle_page_fault(uintptr_t virt_addr, bool is_present)
+	{
+		auto memory_space = CPU::Processor::current().get_memory_space();
+
+		if (in_kernel_space(virt_addr))
+			return false;
+
+		if (is_present)
+		{
+			memory_space->lock->lock();
+
+			// Only writes to pages of shared writeable regions can be resolved
+			auto *region = lookup(memory_space, virt_addr);
+			uintptr_t page = LibK::round_down_to_multiple<uintptr_t>(virt_addr, PAGE_SIZE);
+			bool is_copy_on_write = region && !region->present && region->config.shared && region->config.writeable;
+
+			if (is_copy_on_write && is_shared_page(memory_space, *region, page))
+				copy_on_write(memory_space, *region, page);
+
+			memory_space->lock->unlock();
+
+			return is_copy_on_write;
+		}
+
+		// Backing the page needs memory, which cannot be taken from this space once its lock is held
+		SwapManager::instance().balance();
+
+		memory_space->lock->lock();
+
+		auto *region = lookup(memory_space, virt_addr);
+		bool is_reserved = region && !region->present;
+
+		// Another thread might have faulted on the same page in the meantime
+		uintptr_t page = LibK::round_down_to_multiple<uintptr_t>(virt_addr, PAGE_SIZE);
+		size_t slot;
+
+		if (is_reserved && Arch::get_swap_entry(memory_space->paging_space, page, slot))
+		{
+			mapping_config_t config = region->config;
+			memory_space->lock->unlock();
+
+			// Reading from the disk may block, so the lock is dropped and the swap entry gets checked again afterwards.
+			// Should the page have changed meanwhile, the access simply faults again.
+			SwapManager::instance().swap_in(memory_space, page, config);
+
+			return true;
+		}
+
+		if (is_reserved && !Arch::is_mapped(memory_space->paging_space, page))
+			populate(memory_space, *region, page, nullptr);
+
+		memory_space->lock->unlock();
+
+		return is_reserved;
+	}
+
 	memory_region_t VirtualMemoryManager::map_region(uintptr_t phys_addr, size_t size, mapping_config_t config)
 	{
 		auto memory_space = CPU::Processor::current().get_memory_space();
@@ -100,14 +239,13 @@ namespace Kernel::Memory
 
 		bool is_kernel_space = !config.userspace;
 
-		if (is_kernel_space)
-			m_lock.lock();
+		auto &lock = get_lock(memory_space, is_kernel_space);
+		lock.lock();
 
-		region_t region = find_free_region(memory_space, size, is_kernel_space);
-		auto mapping = map(memory_space, phys_addr, region.address, size, config);
+		uintptr_t virt_addr = find_free_address(memory_space, phys_addr, size, config);
+		auto mapping = map(memory_space, phys_addr, virt_addr, size, config);
 
-		if (is_kernel_space)
-			m_lock.unlock();
+		lock.unlock();
 
 		return mapping;
 	}
@@ -120,18 +258,18 @@ namespace Kernel::Memory
 		size = LibK::round_up_to_multiple<size_t>(size + (virt_addr - address), PAGE_SIZE);
 		virt_addr = address;
 
-		bool is_kernel_space = in_kernel_space(virt_addr);
+		auto &lock = get_lock(memory_space, in_kernel_space(virt_addr));
+		lock.lock();
 
-		if (find_region(memory_space, virt_addr))
+		if (lookup(memory_space, virt_addr))
+		{
+			lock.unlock();
 			return {};
-
-		if (is_kernel_space)
-			m_lock.lock();
+		}
 
 		auto mapping = map(memory_space, phys_addr, virt_addr, size, config);
 
-		if (is_kernel_space)
-			m_lock.unlock();
+		lock.unlock();
 
 		return mapping;
 	}
@@ -140,9 +278,16 @@ namespace Kernel::Memory
 	{
 		auto memory_space = CPU::Processor::current().get_memory_space();
 
-		auto region = find_region(memory_space, (uintptr_t)ptr);
-		assert(region);
-		free(*region);
+		auto &lock = get_lock(memory_space, in_kernel_space((uintptr_t)ptr));
+		lock.lock_shared();
+
+		auto *found = lookup(memory_space, (uintptr_t)ptr);
+		assert(found);
+		memory_region_t region = *found;
+
+		lock.unlock_shared();
+
+		free(region);
 	}
 
 	void VirtualMemoryManager::free(const memory_region_t &region)
@@ -151,61 +296,75 @@ namespace Kernel::Memory
 
 		assert(region.mapped);
 
-		bool is_kernel_space = in_kernel_space(region.virt_address);
-		if (is_kernel_space)
-			m_lock.lock();
+		auto &lock = get_lock(memory_space, in_kernel_space(region.virt_address));
+		lock.lock();
 
 		unmap(memory_space, region);
 
-		if (is_kernel_space)
-			m_lock.unlock();
+		lock.unlock();
 
-		if (!region.allocated)
+		// Pages of reserved regions are already released while unmapping
+		if (!region.allocated || !region.present)
 			return;
 
-		assert(region.present); // Swapping not yet implemented
-
 		PhysicalMemoryManager::instance().free((void *)region.phys_address, region.size);
 	}
 
-	region_t VirtualMemoryManager::find_free_region(memory_space_t *memory_space, size_t size, bool is_kernel_space) const
+	region_t VirtualMemoryManager::find_free_region(memory_space_t *memory_space, size_t size, bool is_kernel_space)
 	{
 		assert(size > 0);
 
-		size_t min_size = SIZE_MAX;
-		region_t min_region{0, 0};
+		auto &free_ranges = is_kernel_space ? m_kernel_free_ranges : memory_space->userland_free_ranges;
+		region_t region = free_ranges.find_best_fit(size);
 
-		traverse_unmapped(memory_space, is_kernel_space, [&](memory_region_t mem_region) {
-			auto region = mem_region.virt_region();
+		// Caches keep their data mapped in kernel space, the lock is dropped so they can unmap it
+		while (region.size == 0 && is_kernel_space)
+		{
+			m_kernel_lock.unlock();
+			size_t freed = ShrinkerRegistry::instance().shrink(LibK::ceil_div<size_t>(size, PAGE_SIZE));
+			m_kernel_lock.lock();
 
-			if (region.size < min_size && region.size >= size)
-			{
-				min_region = region;
-				min_size = region.size;
+			if (freed == 0)
+				break;
 
-				if (min_size == size)
-					return false;
-			}
-
-			return true;
-		});
+			region = free_ranges.find_best_fit(size);
+		}
 
-		// TODO: Implement more metadata to determine memory (like cache) that can be unmapped
-		if (min_region.size == 0)
+		if (region.size == 0)
 			panic("Out of kernel virtual memory (OOM) while allocating buffer of size %u", size);
 
-		return min_region;
+		return region;
+	}
+
+	uintptr_t VirtualMemoryManager::find_free_address(memory_space_t *memory_space, uintptr_t phys_address, size_t size, mapping_config_t config)
+	{
+		bool is_kernel_space = !config.userspace;
+
+		if (!config.huge_pages || size < PAGE_SIZE_HUGE)
+			return find_free_region(memory_space, size, is_kernel_space).address;
+
+		// Pick an address that lines up with the physical one, so every huge page inside the range can be mapped as such
+		region_t region = find_free_region(memory_space, size + PAGE_SIZE_HUGE, is_kernel_space);
+		return region.address + ((phys_address - region.address) & (PAGE_SIZE_HUGE - 1));
 	}
 
 	const memory_region_t *VirtualMemoryManager::find_region(memory_space_t *memory_space, uintptr_t virtual_addr)
 	{
-		auto &tree = in_kernel_space(virtual_addr) ? m_kernel_memory_map : memory_space->userland_map;
+		auto &lock = get_lock(memory_space, in_kernel_space(virtual_addr));
+		lock.lock_shared();
 
-		bool is_kernel_space = in_kernel_space(virtual_addr);
-		if (is_kernel_space)
-			m_lock.lock();
+		auto region = lookup(memory_space, virtual_addr);
 
-		auto region = tree.find([virtual_addr](memory_region_t region) {
+		lock.unlock_shared();
+
+		return region;
+	}
+
+	const memory_region_t *VirtualMemoryManager::lookup(memory_space_t *memory_space, uintptr_t virtual_addr) const
+	{
+		auto &tree = in_kernel_space(virtual_addr) ? m_kernel_memory_map : memory_space->userland_map;
+
+		return tree.find([virtual_addr](memory_region_t region) {
 			if (region.virt_region().contains(virtual_addr))
 				return 0;
 			else if (region.virt_address < virtual_addr)
@@ -213,21 +372,19 @@ namespace Kernel::Memory
 			else
 				return 1;
 		});
-
-		if (is_kernel_space)
-			m_lock.unlock();
-
-		return region;
 	}
 
 	void VirtualMemoryManager::enumerate(const LibK::function<bool(memory_region_t)> &callback)
 	{
 		auto memory_space = CPU::Processor::current().get_memory_space();
+
+		memory_space->lock->lock_shared();
 		memory_space->userland_map.traverse(callback);
+		memory_space->lock->unlock_shared();
 
-		m_lock.lock();
+		m_kernel_lock.lock_shared();
 		m_kernel_memory_map.traverse(callback);
-		m_lock.unlock();
+		m_kernel_lock.unlock_shared();
 	}
 
 	memory_space_t VirtualMemoryManager::create_memory_space()
@@ -236,7 +393,9 @@ namespace Kernel::Memory
 
 		return {
 			.paging_space = paging_space,
-			.userland_map = {}
+			.userland_map = {},
+			.userland_free_ranges = FreeRangeIndex(get_userland_range()),
+			.lock = LibK::shared_ptr<Locking::RWSpinlock>(new Locking::RWSpinlock()),
 		};
 	}
 
@@ -246,17 +405,83 @@ namespace Kernel::Memory
 		memory_space_t space = create_memory_space();
 		memory_space_t *new_space = &space;
 
-		current_space->userland_map.traverse([current_space, new_space](memory_region_t region) {
-			// TODO: copying works for now, but not with file mappings
-			auto final_region = VirtualMemoryManager::instance().allocate_region_at_for(new_space, region.virt_address, region.size, region.config);
-			auto dest_region = VirtualMemoryManager::instance().map_region(final_region.phys_address, region.size, region.config);
-
-			memcpy(dest_region.virt_region().pointer(), region.virt_region().pointer(), region.size);
-
-			VirtualMemoryManager::instance().unmap(current_space, dest_region);
+		LibK::vector<memory_region_t> to_copy;
 
+		// Mapping the copies modifies the current space, so collect the regions first
+		current_space->lock->lock_shared();
+		current_space->userland_map.traverse([&to_copy](memory_region_t region) {
+			to_copy.push_back(region);
 			return true;
 		});
+		current_space->lock->unlock_shared();
+
+		for (auto region : to_copy)
+		{
+			if (region.config.shared && region.present)
+			{
+				new_space->lock->lock();
+				VirtualMemoryManager::instance().map(new_space, region.phys_address, region.virt_address, region.size, region.config);
+				new_space->lock->unlock();
+
+				continue;
+			}
+
+			if (region.config.shared)
+			{
+				current_space->lock->lock_shared();
+				new_space->lock->lock();
+
+				// Pages that have been written to already are private, the child gets a copy of these
+				auto reservation = VirtualMemoryManager::instance().share(new_space, region.phys_address, region.virt_address, region.size, region.config);
+				for (uintptr_t page = region.virt_address; page < region.virt_address + region.size; page += PAGE_SIZE)
+				{
+					if (!VirtualMemoryManager::instance().is_shared_page(current_space, region, page))
+						VirtualMemoryManager::instance().copy_on_write(new_space, reservation, page);
+				}
+
+				new_space->lock->unlock();
+				current_space->lock->unlock_shared();
+
+				continue;
+			}
+
+			if (!region.present)
+			{
+				VirtualMemoryManager::instance().reserve_region_at_for(new_space, region.virt_address, region.size, region.config);
+
+				current_space->lock->lock_shared();
+				new_space->lock->lock();
+
+				// Only the pages that have been touched need to be copied
+				LibK::vector<uintptr_t> swapped_pages;
+				auto *reservation = VirtualMemoryManager::instance().lookup(new_space, region.virt_address);
+				for (uintptr_t page = region.virt_address; page < region.virt_address + region.size; page += PAGE_SIZE)
+				{
+					size_t slot;
+
+					if (Arch::is_mapped(current_space->paging_space, page))
+						VirtualMemoryManager::instance().populate(new_space, *reservation, page, reinterpret_cast<const void *>(page));
+					else if (Arch::get_swap_entry(current_space->paging_space, page, slot))
+						swapped_pages.push_back(page);
+				}
+
+				new_space->lock->unlock();
+				current_space->lock->unlock_shared();
+
+				// Swapped out pages are read from the disk without holding the locks
+				for (auto page : swapped_pages)
+					VirtualMemoryManager::instance().copy_swapped_page(current_space, new_space, region, page);
+
+				continue;
+			}
+
+			// TODO: copying works for now, but not with file mappings
+			auto final_region = VirtualMemoryManager::instance().allocate_region_at_for(new_space, region.virt_address, region.size, region.config);
+
+			// The copies go through the fixed window of this core, so the kernel map stays untouched and no other core has to flush its TLB
+			for (size_t offset = 0; offset < region.size; offset += PAGE_SIZE)
+				Arch::copy_page(final_region.phys_address + offset, reinterpret_cast<const void *>(region.virt_address + offset));
+		}
 
 		return space;
 	}
@@ -267,12 +492,14 @@ namespace Kernel::Memory
 
 		LibK::vector<memory_region_t> to_free;
 
+		current_space->lock->lock_shared();
 		current_space->userland_map.traverse([&to_free](memory_region_t region) {
 			// TODO: this works only for now
 			if (region.config.userspace)
 				to_free.push_back(region);
 			return true;
 		});
+		current_space->lock->unlock_shared();
 
 		for (auto region : to_free)
 			VirtualMemoryManager::instance().free(region);
@@ -290,6 +517,7 @@ namespace Kernel::Memory
 	memory_region_t VirtualMemoryManager::map(memory_space_t *memory_space, uintptr_t phys_address, uintptr_t virt_address, size_t size, mapping_config_t config)
 	{
 		auto &tree = in_kernel_space(virt_address) ? m_kernel_memory_map : memory_space->userland_map;
+		auto &free_ranges = in_kernel_space(virt_address) ? m_kernel_free_ranges : memory_space->userland_free_ranges;
 
 		auto region = memory_region_t{
 		    .virt_address = virt_address,
@@ -302,17 +530,168 @@ namespace Kernel::Memory
 		};
 
 		tree.insert(region);
+		free_ranges.reserve(region.virt_region());
 		Arch::map(memory_space->paging_space, phys_address, virt_address, size, config);
 
 		return region;
 	}
 
+	memory_region_t VirtualMemoryManager::reserve(memory_space_t *memory_space, uintptr_t virt_address, size_t size, mapping_config_t config)
+	{
+		auto &tree = in_kernel_space(virt_address) ? m_kernel_memory_map : memory_space->userland_map;
+		auto &free_ranges = in_kernel_space(virt_address) ? m_kernel_free_ranges : memory_space->userland_free_ranges;
+
+		auto region = memory_region_t{
+		    .virt_address = virt_address,
+		    .phys_address = 0,
+		    .size = size,
+		    .mapped = true,
+		    .present = false,
+		    .allocated = true,
+		    .config = config,
+		};
+
+		tree.insert(region);
+		free_ranges.reserve(region.virt_region());
+
+		return region;
+	}
+
+	void VirtualMemoryManager::populate(memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address, const void *source)
+	{
+		assert(!region.present);
+
+		// Pages of the pool are already zeroed, but they may not satisfy the physical bounds of the region
+		bool is_unbounded = region.config.bounds.address == 0 && region.config.bounds.size == SIZE_MAX;
+		uintptr_t phys_address = !source && is_unbounded ? ZeroPagePool::instance().take() : 0;
+
+		if (!phys_address)
+		{
+			phys_address = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(PAGE_SIZE, region.config.bounds.address, region.config.bounds.end()));
+
+			if (source)
+				Arch::copy_page(phys_address, source);
+			else
+				Arch::zero_page(phys_address);
+		}
+
+		Arch::map(memory_space->paging_space, phys_address, virt_address, PAGE_SIZE, region.config);
+	}
+
+	void VirtualMemoryManager::copy_swapped_page(memory_space_t *source_space, memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address)
+	{
+		assert(!region.present);
+
+		uintptr_t phys_address = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(PAGE_SIZE, region.config.bounds.address, region.config.bounds.end()));
+
+		// Other threads of the source may read the page back in meanwhile, it is copied from memory then
+		while (!SwapManager::instance().read(source_space, virt_address, phys_address))
+		{
+			size_t slot;
+
+			source_space->lock->lock_shared();
+
+			bool is_mapped = Arch::is_mapped(source_space->paging_space, virt_address);
+			if (is_mapped)
+				Arch::copy_page(phys_address, reinterpret_cast<const void *>(virt_address));
+
+			bool is_swapped = !is_mapped && Arch::get_swap_entry(source_space->paging_space, virt_address, slot);
+
+			source_space->lock->unlock_shared();
+
+			if (is_mapped)
+				break;
+
+			// Unmapped in the meantime, the copy stays unbacked
+			if (!is_swapped)
+			{
+				PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(phys_address), PAGE_SIZE);
+				return;
+			}
+		}
+
+		memory_space->lock->lock();
+		Arch::map(memory_space->paging_space, phys_address, virt_address, PAGE_SIZE, region.config);
+		memory_space->lock->unlock();
+	}
+
+	memory_region_t VirtualMemoryManager::share(memory_space_t *memory_space, uintptr_t phys_address, uintptr_t virt_address, size_t size, mapping_config_t config)
+	{
+		assert(config.shared);
+
+		if (!config.writeable)
+			return map(memory_space, phys_address, virt_address, size, config);
+
+		// The region is managed page by page, as written pages get replaced by private copies
+		auto &tree = in_kernel_space(virt_address) ? m_kernel_memory_map : memory_space->userland_map;
+		auto &free_ranges = in_kernel_space(virt_address) ? m_kernel_free_ranges : memory_space->userland_free_ranges;
+
+		auto region = memory_region_t{
+		    .virt_address = virt_address,
+		    .phys_address = phys_address,
+		    .size = size,
+		    .mapped = true,
+		    .present = false,
+		    .allocated = false,
+		    .config = config,
+		};
+
+		tree.insert(region);
+		free_ranges.reserve(region.virt_region());
+
+		auto read_only_config = config;
+		read_only_config.writeable = false;
+		Arch::map(memory_space->paging_space, phys_address, virt_address, size, read_only_config);
+
+		return region;
+	}
+
+	void VirtualMemoryManager::copy_on_write(memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address)
+	{
+		assert(region.config.shared && !region.present);
+
+		uintptr_t phys_address = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(PAGE_SIZE, region.config.bounds.address, region.config.bounds.end()));
+
+		// The shared page is still mapped read-only in the current memory space
+		Arch::copy_page(phys_address, reinterpret_cast<const void *>(virt_address));
+
+		Arch::unmap(memory_space->paging_space, virt_address, PAGE_SIZE);
+		Arch::map(memory_space->paging_space, phys_address, virt_address, PAGE_SIZE, region.config);
+	}
+
+	bool VirtualMemoryManager::is_shared_page(memory_space_t *memory_space, const memory_region_t &region, uintptr_t virt_address) const
+	{
+		uintptr_t phys_address = Arch::as_physical_for(memory_space->paging_space, virt_address);
+		return region.phys_region().contains(phys_address);
+	}
+
 	void VirtualMemoryManager::unmap(memory_space_t *memory_space, const memory_region_t &region)
 	{
 		auto &tree = in_kernel_space(region.virt_address) ? m_kernel_memory_map : memory_space->userland_map;
+		auto &free_ranges = in_kernel_space(region.virt_address) ? m_kernel_free_ranges : memory_space->userland_free_ranges;
+
+		if (region.present)
+		{
+			Arch::unmap(memory_space->paging_space, region.virt_address, region.size);
+		}
+		else
+		{
+			Arch::unmap_sparse(
+			    memory_space->paging_space, region.virt_address, region.size,
+			    [&region](uintptr_t phys_address) {
+				    // Pages that are still shared belong to somebody else
+				    if (region.config.shared && region.phys_region().contains(phys_address))
+					    return;
+
+				    PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(phys_address), PAGE_SIZE);
+			    },
+			    [](size_t slot) {
+				    SwapManager::instance().release(slot);
+			    });
+		}
 
-		Arch::unmap(memory_space->paging_space, region.virt_address, region.size);
 		tree.remove(region);
+		free_ranges.release(region.virt_region());
 	}
 
 	bool VirtualMemoryManager::check_free(memory_space_t *memory_space, const region_t &region) const
@@ -421,6 +800,26 @@ namespace Kernel::Memory
 		});
 	}
 
+	Locking::RWSpinlock &VirtualMemoryManager::get_lock(memory_space_t *memory_space, bool is_kernel_space)
+	{
+		if (is_kernel_space)
+			return m_kernel_lock;
+
+		assert(memory_space->lock);
+		return *memory_space->lock;
+	}
+
+	region_t VirtualMemoryManager::get_userland_range()
+	{
+		return {0, reinterpret_cast<uintptr_t>(&_virtual_addr)};
+	}
+
+	region_t VirtualMemoryManager::get_kernel_space_range()
+	{
+		uintptr_t start = reinterpret_cast<uintptr_t>(&_virtual_addr);
+		return {start, UINTPTR_MAX - start + 1};
+	}
+
 	bool VirtualMemoryManager::in_kernel_space(uintptr_t virt_address) const
 	{
 		return virt_address >= reinterpret_cast<uintptr_t>(&_virtual_addr);
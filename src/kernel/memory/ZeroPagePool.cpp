@@ -0,0 +1,64 @@
+#include <memory/ZeroPagePool.hpp>
+
+#include <arch/memory.hpp>
+#include <memory/PhysicalMemoryManager.hpp>
+#include <memory/ShrinkerRegistry.hpp>
+
+namespace Kernel::Memory
+{
+	ZeroPagePool::ZeroPagePool()
+	{
+		ShrinkerRegistry::instance().register_shrinker([this](size_t page_count) {
+			return drain(page_count);
+		});
+	}
+
+	uintptr_t ZeroPagePool::take()
+	{
+		m_lock.lock();
+		uintptr_t page = m_count > 0 ? m_pages[--m_count] : 0;
+		m_lock.unlock();
+
+		return page;
+	}
+
+	bool ZeroPagePool::refill()
+	{
+		if (m_count >= CAPACITY || PhysicalMemoryManager::instance().get_free_memory() < MIN_FREE_MEMORY)
+			return false;
+
+		uintptr_t page = reinterpret_cast<uintptr_t>(PhysicalMemoryManager::instance().alloc(PAGE_SIZE));
+		Arch::zero_page(page);
+
+		m_lock.lock();
+
+		// Another core may have filled up the pool in the meantime
+		bool is_full = m_count >= CAPACITY;
+		if (!is_full)
+			m_pages[m_count++] = page;
+
+		m_lock.unlock();
+
+		if (is_full)
+			PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(page), PAGE_SIZE);
+
+		return !is_full;
+	}
+
+	size_t ZeroPagePool::drain(size_t page_count)
+	{
+		size_t drained = 0;
+
+		while (drained < page_count)
+		{
+			uintptr_t page = take();
+			if (!page)
+				break;
+
+			PhysicalMemoryManager::instance().free(reinterpret_cast<void *>(page), PAGE_SIZE);
+			drained++;
+		}
+
+		return drained;
+	}
+} // namespace Kernel::Memory
@@ -2,8 +2,10 @@
 
 #include <libk/kcstdio.hpp>
 
+#include <locking/RCU.hpp>
 #include <logging/logger.hpp>
 #include <arch/Processor.hpp>
+#include <memory/ZeroPagePool.hpp>
 #include <time/EventManager.hpp>
 
 namespace Kernel
@@ -32,7 +34,7 @@ namespace Kernel
 			current_thread->state = ThreadState::Ready;
 		next_thread->state = ThreadState::Running;
 		core.m_current_thread = next_thread;
-		core.m_memory_space = next_thread->parent_process ? &next_thread->parent_process->get_memory_space() : Memory::VirtualMemoryManager::instance().get_kernel_memory_space();
+		core.set_memory_space(next_thread->parent_process ? &next_thread->parent_process->get_memory_space() : Memory::VirtualMemoryManager::instance().get_kernel_memory_space());
 
 		if (current_thread && current_thread->has_started)
 			core.update_thread_context(*current_thread);
@@ -54,8 +56,13 @@ namespace Kernel
 		}
 
 		if (core.get_irq_counter() <= 1)
+		{
 			core.process_deferred_queue();
 
+			// Read-side sections cannot span the switch, as they keep preemption disabled
+			Locking::RCU::instance().quiescent_state();
+		}
+
 		if (next_thread->parent_process && next_thread->parent_process->has_pending_signal())
 			next_thread->parent_process->prepare_next_signal(next_thread);
 	}
@@ -88,7 +95,7 @@ namespace Kernel
 				if (next == core.m_current_thread)
 					break;
 
-				kfree(reinterpret_cast<void *>(next->kernel_stack));
+				CPU::Processor::release_kernel_stack(next);
 				core.m_running_threads.erase(core.m_running_threads.begin() + core.m_current_thread_index);
 
 				if (core.m_running_threads.empty())
@@ -152,6 +159,10 @@ namespace Kernel
 	__noreturn void CoreScheduler::idle()
 	{
 		for (;;)
-			CPU::Processor::sleep();
+		{
+			// Prepare zeroed pages while there is nothing else to do
+			if (!Memory::ZeroPagePool::instance().refill())
+				CPU::Processor::sleep();
+		}
 	}
 }
@@ -3,10 +3,12 @@
 #include <atomic>
 
 #include <processes/GlobalScheduler.hpp>
+#include <memory/SwapManager.hpp>
 #include <memory/VirtualMemoryManager.hpp>
 #include <arch/Processor.hpp>
 #include <elf/elf.hpp>
 #include <logging/logger.hpp>
+#include <time/TimePage.hpp>
 #include <tty/VirtualConsole.hpp>
 
 namespace Kernel
@@ -17,6 +19,7 @@ namespace Kernel
 	{
 		m_pid = ++s_pid_counter;
 		m_memory_space = Memory::VirtualMemoryManager::create_memory_space();
+		Memory::SwapManager::instance().add_memory_space(&m_memory_space);
 
 		for (size_t i = 0; i < m_signal_handlers.size(); i++)
 			m_signal_handlers[i] = SIG_DFL;
@@ -28,6 +31,8 @@ namespace Kernel
 		auto config = Memory::mapping_config_t { .userspace = true };
 		m_signal_trampoline = Memory::VirtualMemoryManager::instance().allocate_region_at(0x1000, signal_trampoline_size, config);
 		memcpy(m_signal_trampoline.virt_region().pointer(), (void *)signal_trampoline_address, signal_trampoline_size);
+
+		Time::TimePage::instance().map();
 	}
 
 	void Process::start_thread(size_t index)
@@ -63,6 +68,18 @@ namespace Kernel
 		m_opened_files[fd] = FileContext();
 	}
 
+	void Process::set_executable_image(ELF::image_t *image, ELF::image_t *loader_image)
+	{
+		if (m_executable_image)
+			ELF::release_image(m_executable_image);
+
+		if (m_loader_image)
+			ELF::release_image(m_loader_image);
+
+		m_executable_image = image;
+		m_loader_image = loader_image;
+	}
+
 	void Process::exec(File *file, const char **argv, const char **envp)
 	{
 		thread_t *main_thread = CPU::Processor::current().get_current_thread();
@@ -82,6 +99,9 @@ namespace Kernel
 		//       as threads may still be running on different cores.
 		Memory::VirtualMemoryManager::free_current_userspace();
 
+		// The old images are not mapped anymore, so they must not stay pinned if loading the new one fails
+		set_executable_image(nullptr, nullptr);
+
 		uintptr_t signal_trampoline_address;
 		uintptr_t signal_trampoline_size;
 
@@ -90,6 +110,8 @@ namespace Kernel
 		m_signal_trampoline = Memory::VirtualMemoryManager::instance().allocate_region_at(0x1000, signal_trampoline_size, config);
 		memcpy(m_signal_trampoline.virt_region().pointer(), (void *)signal_trampoline_address, signal_trampoline_size);
 
+		Time::TimePage::instance().map();
+
 		assert(ELF::load(this, file, argv, envp, true));
 
 		CPU::interrupt_frame_t *frame = CPU::Processor::current().get_interrupt_frame_stack().top();
@@ -146,6 +168,12 @@ namespace Kernel
 		// NOTE: The corresponding core scheduler handles final termination of threads
 		for (auto thread : m_threads)
 			thread->state = ThreadState::Terminated;
+
+		// No thread runs from the images anymore, so the cache may reclaim them once no other process references them
+		set_executable_image(nullptr, nullptr);
+
+		// Paging out the memory of a zombie would only waste swap space
+		Memory::SwapManager::instance().remove_memory_space(&m_memory_space);
 	}
 
 	LibK::ErrorOr<pid_t> Process::waitpid(pid_t pid, int *stat_loc, int options)
@@ -289,6 +317,13 @@ namespace Kernel
 		m_pid = ++s_pid_counter;
 		m_cwd = LibK::string(other->m_cwd.c_str());
 		m_memory_space = Memory::VirtualMemoryManager::copy_current_memory_space();
+		Memory::SwapManager::instance().add_memory_space(&m_memory_space);
+		m_executable_image = other->m_executable_image;
+		if (m_executable_image)
+			ELF::retain_image(m_executable_image);
+		m_loader_image = other->m_loader_image;
+		if (m_loader_image)
+			ELF::retain_image(m_loader_image);
 		m_parent = other;
 		m_signal_handlers = other->m_signal_handlers;
 		m_signal_trampoline = other->m_signal_trampoline;
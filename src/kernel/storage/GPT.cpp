@@ -67,7 +67,7 @@ namespace Kernel::GPT
 			if (type_guid == UNUSED)
 				continue;
 
-			device.add_partition(partition_entry.start_lba, partition_entry.end_lba - partition_entry.start_lba);
+			device.add_partition(partition_entry.start_lba, partition_entry.end_lba - partition_entry.start_lba, type_guid);
 		}
 
 		Memory::VirtualMemoryManager::instance().free(header_region);
@@ -4,11 +4,12 @@
 
 namespace Kernel
 {
-	PartitionDevice::PartitionDevice(StorageDevice *device, size_t offset, size_t length)
+	PartitionDevice::PartitionDevice(StorageDevice *device, size_t offset, size_t length, const LibK::GUID &type)
 		: BlockDevice(65, 0)
 	    , m_offset(offset)
 		, m_length(length)
 		, m_storage_device(device)
+		, m_type(type)
 	{
 	}
 
@@ -0,0 +1,32 @@
+#include <syscall/syscalls.hpp>
+
+#include <time/Clock.hpp>
+#include <time/EventManager.hpp>
+
+namespace Kernel
+{
+	uintptr_t syscall$clock_gettime(clockid_t clock_id, struct timespec *tp)
+	{
+		if (!tp)
+			return -EINVAL;
+
+		uint64_t now;
+
+		switch (clock_id)
+		{
+		case CLOCK_REALTIME:
+			now = Time::Clock::instance().realtime();
+			break;
+		case CLOCK_MONOTONIC:
+			now = Time::Clock::instance().now();
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		tp->tv_sec = now / Time::from_seconds(1);
+		tp->tv_nsec = now % Time::from_seconds(1);
+
+		return 0;
+	}
+}
@@ -0,0 +1,39 @@
+#include <syscall/syscalls.hpp>
+
+#include <time/Clock.hpp>
+#include <time/EventManager.hpp>
+
+namespace Kernel
+{
+	uintptr_t syscall$clock_nanosleep(clockid_t clock_id, int flags, const struct timespec *request, struct timespec *remain)
+	{
+		if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC)
+			return -EINVAL;
+
+		if (!request || request->tv_sec < 0 || request->tv_nsec < 0 || request->tv_nsec >= 1000000000)
+			return -EINVAL;
+
+		uint64_t nanoseconds = Time::from_seconds(request->tv_sec) + request->tv_nsec;
+
+		if (flags & TIMER_ABSTIME)
+		{
+			// The wall clock is the monotonic clock shifted by the boot time, so both deadlines become the same relative sleep
+			auto &clock = Time::Clock::instance();
+			uint64_t now = clock_id == CLOCK_REALTIME ? clock.realtime() : clock.now();
+
+			if (nanoseconds <= now)
+				return 0;
+
+			nanoseconds -= now;
+		}
+
+		if (nanoseconds > 0)
+			Time::EventManager::instance().nanosleep(nanoseconds);
+
+		// Sleeps cannot be interrupted by signals yet, so nothing is ever left over
+		if (remain && !(flags & TIMER_ABSTIME))
+			*remain = {.tv_sec = 0, .tv_nsec = 0};
+
+		return 0;
+	}
+}
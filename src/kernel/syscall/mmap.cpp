@@ -38,10 +38,10 @@ namespace Kernel
 		};
 
 		// MAP_ANONYMOUS: The mapping is not backed by any file; its contents are initialized to zero.
-		auto region = Memory::VirtualMemoryManager::instance().allocate_region(len, config);
-		memset(reinterpret_cast<void *>(region.virt_address), 0, region.size);
+		// Pages are backed by zeroed memory once they are touched for the first time.
+		auto region = Memory::VirtualMemoryManager::instance().reserve_region(len, config);
 
-		if (!region.present)
+		if (!region.mapped)
 			return -ENOMEM;
 
 		return region.virt_address;
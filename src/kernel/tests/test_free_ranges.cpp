@@ -0,0 +1,110 @@
+#include <tests.hpp>
+
+#include "definitions.hpp"
+
+#include <memory/FreeRangeIndex.hpp>
+
+#include <logging/logger.hpp>
+
+namespace Kernel::Tests
+{
+	using Kernel::Memory::FreeRangeIndex;
+	using Kernel::Memory::region_t;
+
+	static bool is_range(region_t range, uintptr_t address, size_t size)
+	{
+		return range.address == address && range.size == size;
+	}
+
+	static bool test_best_fit()
+	{
+		FreeRangeIndex index({0x1000, 0x10000});
+
+		// Leaves [0x1000, 0x3000) and [0x4000, 0x11000) free
+		index.reserve({0x3000, 0x1000});
+
+		if (!is_range(index.find_best_fit(0x1000), 0x1000, 0x2000))
+		{
+			log(get_tag(false), "Best fit: smallest fitting range not chosen");
+			return false;
+		}
+
+		if (!is_range(index.find_best_fit(0x3000), 0x4000, 0xD000))
+		{
+			log(get_tag(false), "Best fit: larger range not chosen");
+			return false;
+		}
+
+		if (index.find_best_fit(0x20000).size != 0)
+		{
+			log(get_tag(false), "Best fit: range returned for an oversized request");
+			return false;
+		}
+
+		log(get_tag(true), "Best fit");
+		return true;
+	}
+
+	static bool test_coalescing()
+	{
+		FreeRangeIndex index({0x1000, 0x10000});
+
+		index.reserve({0x3000, 0x1000});
+		index.reserve({0x6000, 0x2000});
+
+		// Releasing the ranges in between has to merge everything back into one range
+		index.release({0x6000, 0x2000});
+		index.release({0x3000, 0x1000});
+
+		if (!is_range(index.find_best_fit(0x1000), 0x1000, 0x10000))
+		{
+			log(get_tag(false), "Coalescing: neighbours not merged on release");
+			return false;
+		}
+
+		log(get_tag(true), "Coalescing");
+		return true;
+	}
+
+	static bool test_spanning_reserve()
+	{
+		FreeRangeIndex index({0x1000, 0x10000});
+
+		index.reserve({0x3000, 0x1000});
+
+		// Overlaps the end of the first and the start of the second free range
+		index.reserve({0x2000, 0x4000});
+
+		if (!is_range(index.find_best_fit(0x1000), 0x1000, 0x1000))
+		{
+			log(get_tag(false), "Spanning reserve: first range not trimmed");
+			return false;
+		}
+
+		if (!is_range(index.find_best_fit(0x2000), 0x6000, 0xB000))
+		{
+			log(get_tag(false), "Spanning reserve: second range not trimmed");
+			return false;
+		}
+
+		log(get_tag(true), "Spanning reserve");
+		return true;
+	}
+
+	bool test_free_ranges()
+	{
+		log("TEST", "Free range index");
+		bool ok = true;
+
+		if (!test_best_fit())
+			ok = false;
+
+		if (!test_coalescing())
+			ok = false;
+
+		if (!test_spanning_reserve())
+			ok = false;
+
+		return ok;
+	}
+} // namespace Kernel::Tests
@@ -0,0 +1,89 @@
+#include <time/Clock.hpp>
+
+#include <arch/Processor.hpp>
+#include <arch/i686/cpuid.hpp>
+#include <logging/logger.hpp>
+#include <time/EventManager.hpp>
+#include <time/RTC.hpp>
+#include <time/TimePage.hpp>
+
+namespace Kernel::Time
+{
+	void Clock::calibrate()
+	{
+		calibrate_tsc();
+
+		m_boot_time = from_seconds(RTC::instance().read_unix_time()) - now();
+
+		log("CLOCK", "Booted at %u seconds since the epoch", (uint32_t)(m_boot_time / from_seconds(1)));
+	}
+
+	void Clock::calibrate_tsc()
+	{
+		if (!(cpuid(CPUID_LEAF_FEATURES).edx & CPUID_FEATURE_EDX_TSC))
+		{
+			log("CLOCK", "No TSC available, using the timer interrupts");
+			return;
+		}
+
+		if (cpuid(CPUID_LEAF_EXTENDED_MAX).eax >= CPUID_LEAF_ADVANCED_POWER)
+			m_tsc_invariant = cpuid(CPUID_LEAF_ADVANCED_POWER).edx & CPUID_ADVANCED_POWER_EDX_INVARIANT_TSC;
+
+		// Frequency changes and sleep states would skew or stop a TSC that is not invariant
+		if (!m_tsc_invariant)
+		{
+			log("CLOCK", "TSC is not invariant, using the timer interrupts");
+			return;
+		}
+
+		uint64_t start = CPU::Processor::read_tsc();
+		EventManager::instance().early_sleep(CALIBRATION_MICROSECONDS);
+		uint64_t ticks = CPU::Processor::read_tsc() - start;
+
+		assert(ticks > 0);
+
+		m_tsc_frequency = ticks * (from_seconds(1) / from_microseconds(CALIBRATION_MICROSECONDS));
+		m_tsc_scale = (from_microseconds(CALIBRATION_MICROSECONDS) << SCALE_SHIFT) / ticks;
+
+		// The TSC has counted since reset, but the clock has only counted the timer interrupts since they were set up.
+		// Both are read with interrupts disabled, so no tick can land in between.
+		CPU::Processor::current().enter_critical();
+		m_tsc_offset = static_cast<int64_t>(tick_time()) - static_cast<int64_t>(convert(CPU::Processor::read_tsc()));
+		m_uses_tsc.store(true, std::memory_order_release);
+		CPU::Processor::current().leave_critical();
+
+		log("CLOCK", "Using the invariant TSC at %u kHz", (uint32_t)(m_tsc_frequency / 1000));
+	}
+
+	void Clock::tick(uint64_t nanoseconds)
+	{
+		m_tick_time_lock.write_lock();
+		m_tick_time += nanoseconds;
+		m_tick_time_lock.write_unlock();
+
+		// Userspace interpolates the TSC on its own and only needs the tick time without one
+		if (!uses_tsc())
+			TimePage::instance().update();
+	}
+
+	uint64_t Clock::now() const
+	{
+		if (!uses_tsc())
+			return tick_time();
+
+		return convert(CPU::Processor::read_tsc()) + m_tsc_offset;
+	}
+
+	uint64_t Clock::tick_time() const
+	{
+		return m_tick_time_lock.read([this]() { return m_tick_time; });
+	}
+
+	uint64_t Clock::convert(uint64_t tsc) const
+	{
+		// The multiplication is split up, so it cannot overflow no matter how long the system runs
+		uint64_t low_mask = (1ull << SCALE_SHIFT) - 1;
+
+		return (tsc >> SCALE_SHIFT) * m_tsc_scale + (((tsc & low_mask) * m_tsc_scale) >> SCALE_SHIFT);
+	}
+} // namespace Kernel::Time
@@ -1,6 +1,7 @@
 #include <time/EventManager.hpp>
 
 #include <libk/kcstdio.hpp>
+#include <libk/kmath.hpp>
 
 #include <arch/Processor.hpp>
 
@@ -13,17 +14,45 @@ namespace Kernel::Time
 		timer->set_reduce_callback([this](Timer &timer, uint64_t nanoseconds){ return reduce_by(timer, nanoseconds); });
 	}
 
-	void EventManager::usleep(uint64_t usecs)
+	bool TimerHandle::cancel()
+	{
+		if (!m_state)
+			return false;
+
+		return !m_state->done.exchange(true, std::memory_order_acq_rel);
+	}
+
+	void TimerHandle::reschedule(uint64_t nanoseconds)
+	{
+		assert(m_state);
+
+		cancel();
+		*this = EventManager::instance().schedule_event(m_state->callback, nanoseconds, m_state->core_local);
+	}
+
+	void EventManager::nanosleep(uint64_t nanoseconds)
 	{
-		thread_t *current_thread = CPU::Processor::current().get_current_thread();
+		CPU::Processor &core = CPU::Processor::current();
+		thread_t *current_thread = core.get_current_thread();
+
+		// The thread is parked before its wakeup is queued, so a short sleep cannot be woken before it started
+		core.enter_critical();
+		current_thread->state = ThreadState::Sleeping;
 
 		schedule_event([current_thread](){
 			current_thread->state = CPU::Processor::current().get_current_thread() == current_thread ? ThreadState::Running : ThreadState::Ready;
-		}, usecs * 1000,true);
+		}, nanoseconds, true);
 
-		current_thread->state = ThreadState::Sleeping;
+		core.leave_critical();
+
+		// The scheduler skips sleeping threads, halting just hands the core over at the next tick
 		while (current_thread->state == ThreadState::Sleeping)
-			;
+			CPU::Processor::sleep();
+	}
+
+	void EventManager::usleep(uint64_t usecs)
+	{
+		nanosleep(from_microseconds(usecs));
 	}
 
 	void EventManager::sleep(uint64_t millis)
@@ -44,158 +73,128 @@ namespace Kernel::Time
 			;
 	}
 
-	void EventManager::schedule_event(const LibK::function<void()> &callback, uint64_t nanoseconds, bool core_sensitive)
+	TimerHandle EventManager::schedule_event(const LibK::function<void()> &callback, uint64_t nanoseconds, bool core_sensitive)
 	{
-		event_t event{
-			.callback = callback,
-			.nanoseconds = nanoseconds,
-			.core_local = core_sensitive,
-			.used_timer = nullptr,
-		};
-
-		CPU::Processor::current().enter_critical();
-		EventQueue &event_queue = core_sensitive ? CPU::Processor::current().get_event_queue() : m_scheduled_events;
-		auto queue = event_queue.get();
-		schedule_on(event, *queue);
-		CPU::Processor::current().leave_critical();
-	}
-
-	void EventManager::schedule_on(event_t &event, LibK::vector<event_t> &event_queue)
-	{
-		bool updated_schedule = false;
-
-		for (auto it = event_queue.begin(); it != event_queue.end(); ++it)
-		{
-			if (event.nanoseconds <= it->nanoseconds)
-			{
-				bool reschedule = it == event_queue.begin();
+		LibK::shared_ptr<TimerHandle::state_t> state(new TimerHandle::state_t{
+		    .done = false,
+		    .callback = callback,
+		    .core_local = core_sensitive,
+		});
 
-				if (reschedule && !updated_schedule)
-				{
-					uint64_t elapsed = it->used_timer->stop();
-					update_queue(event_queue, elapsed);
-					updated_schedule = true;
-					it--;
-					continue;
-				}
+		lock_queue(core_sensitive);
 
-				it->nanoseconds -= event.nanoseconds;
-				event_queue.insert(it, event);
+		EventQueue &event_queue = queue_for(core_sensitive);
 
-				if (reschedule)
-					schedule_next_event(event_queue);
+		bool is_earliest = event_queue.insert(nanoseconds, [state](){
+			if (!state->done.exchange(true, std::memory_order_acq_rel))
+				state->callback();
+		});
 
-				return;
-			}
+		if (is_earliest)
+		{
+			// The new event comes first, account for the time the running timer has already counted
+			if (event_queue.armed_timer())
+				event_queue.advance(event_queue.armed_timer()->stop());
 
-			event.nanoseconds -= it->nanoseconds;
+			arm(event_queue, core_sensitive);
 		}
 
-		event_queue.push_back(event);
-		if (event_queue.size() == 1)
-			schedule_next_event(event_queue);
-	}
+		unlock_queue(core_sensitive);
 
-	void EventManager::update_queue(LibK::vector<event_t> &event_queue, uint64_t nanoseconds)
-	{
-		for (auto &it : event_queue)
-		{
-			it.nanoseconds -= nanoseconds;
-		}
+		return TimerHandle(state);
 	}
 
 	void EventManager::handle_event(Timer &timer)
 	{
-		event_t event;
+		LibK::function<void()> callback;
 
 		CPU::Processor &core = CPU::Processor::current();
-		EventQueue &event_queue = timer.timer_type() == TimerType::CPU ? core.get_event_queue() : m_scheduled_events;
+		bool core_local = timer.timer_type() == TimerType::CPU;
+		EventQueue &event_queue = queue_for(core_local);
 
 		while (true)
 		{
-			{
-				auto queue = event_queue.get();
+			lock_queue(core_local);
+			bool expired = event_queue.pop_expired(callback);
 
-				if (queue->empty())
-					return;
-
-				event = queue->front();
-				queue->erase(queue->begin());
+			if (!expired)
+			{
+				arm(event_queue, core_local);
+				unlock_queue(core_local);
+				return;
 			}
 
+			unlock_queue(core_local);
+
 			if (core.is_scheduler_running())
-				CPU::Processor::current().defer_call(std::move(event.callback));
+				core.defer_call(std::move(callback));
 			else
-				event.callback();
-
-			{
-				auto queue = event_queue.get();
-
-				if (!queue->empty() && queue->front().nanoseconds == 0)
-					continue;
-
-				schedule_next_event(*queue);
-				break;
-			}
+				callback();
 		}
 	}
 
 	uint64_t EventManager::reduce_by(Timer &timer, uint64_t nanoseconds)
 	{
-		CPU::Processor &core = CPU::Processor::current();
-		EventQueue &event_queue = timer.timer_type() == TimerType::CPU ? core.get_event_queue() : m_scheduled_events;
-		auto queue = event_queue.get();
-		update_queue(*queue, nanoseconds);
-		uint64_t remaining = 0;
-		if (!queue->empty())
-			remaining = queue->front().nanoseconds;
+		bool core_local = timer.timer_type() == TimerType::CPU;
+
+		lock_queue(core_local);
+
+		EventQueue &event_queue = queue_for(core_local);
+		event_queue.advance(nanoseconds);
+		uint64_t remaining = event_queue.time_to_next();
+
+		unlock_queue(core_local);
+
 		return remaining;
 	}
 
-	void EventManager::schedule_next_event(LibK::vector<event_t> &event_queue)
+	void EventManager::arm(EventQueue &event_queue, bool core_local)
 	{
 		if (event_queue.empty())
+		{
+			event_queue.set_armed_timer(nullptr);
 			return;
+		}
 
-		event_t &event = event_queue.front();
-		uint64_t largest_possible_time = 0;
 		Timer *best_timer = nullptr;
 
-		assert(event.nanoseconds > 0);
-
 		for (auto timer : m_available_timers)
 		{
-			if ((timer->timer_type() != TimerType::CPU && event.core_local) || (timer->timer_type() != TimerType::Global && !event.core_local))
+			if ((timer->timer_type() == TimerType::CPU) != core_local)
 				continue;
 
-			uint64_t interval = (event.nanoseconds) / timer->get_time_quantum_in_ns();
-
-			if (interval <= timer->get_maximum_interval())
-			{
-				timer->start(interval);
-				event.used_timer = timer;
-				return;
-			}
-			else if (timer->get_maximum_interval() > largest_possible_time)
-			{
-				largest_possible_time = timer->get_maximum_interval() * timer->get_time_quantum_in_ns();
+			if (!best_timer || timer->get_maximum_interval() * timer->get_time_quantum_in_ns() > best_timer->get_maximum_interval() * best_timer->get_time_quantum_in_ns())
 				best_timer = timer;
-			}
 		}
 
 		assert(best_timer);
 
-		size_t needed_events = event.nanoseconds / largest_possible_time;
-		event.nanoseconds -= needed_events * largest_possible_time;
+		// Deadlines beyond the reach of the timer are approached in steps, every expiry rearms the queue
+		uint64_t interval = event_queue.time_to_next() / best_timer->get_time_quantum_in_ns();
+		interval = LibK::max<uint64_t>(LibK::min<uint64_t>(interval, best_timer->get_maximum_interval()), 1);
 
-		event_t new_event{
-		    .callback = [](){},
-		    .nanoseconds = largest_possible_time,
-		    .core_local = event.core_local,
-		    .used_timer = best_timer,
-		};
+		best_timer->start(interval);
+		event_queue.set_armed_timer(best_timer);
+	}
+
+	EventManager::EventQueue &EventManager::queue_for(bool core_local)
+	{
+		return core_local ? CPU::Processor::current().get_event_queue() : m_scheduled_events;
+	}
 
-		event_queue.insert(event_queue.begin(), needed_events, new_event);
-		best_timer->start(best_timer->get_maximum_interval());
+	void EventManager::lock_queue(bool core_local)
+	{
+		CPU::Processor::current().enter_critical();
+
+		if (!core_local)
+			m_scheduled_events_lock.lock();
+	}
+
+	void EventManager::unlock_queue(bool core_local)
+	{
+		if (!core_local)
+			m_scheduled_events_lock.unlock();
+
+		CPU::Processor::current().leave_critical();
 	}
 } // namespace Kernel::Time
@@ -31,6 +31,8 @@ namespace Kernel::Time
 
 		uint8_t command = CMD_CHANNEL_0 | CMD_ACCESS_FULL_WORD | CMD_MODE_BINARY | CMD_MODE_INT;
 
+		m_current_interval = interval;
+
 		if (interval == 65536)
 			interval = 0;
 
@@ -50,6 +52,7 @@ namespace Kernel::Time
 	void PIT::handle_interrupt(const CPU::interrupt_frame_t &regs __unused)
 	{
 		// TODO: investigate missed PIT interrupts
+		m_reduce_callback(*this, m_current_interval * get_time_quantum_in_ns());
 		m_handle_callback(*this);
 	}
 } // namespace Kernel::Time
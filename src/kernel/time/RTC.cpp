@@ -0,0 +1,115 @@
+#include <time/RTC.hpp>
+
+#define RTC_REG_SECOND   0x00
+#define RTC_REG_MINUTE   0x02
+#define RTC_REG_HOUR     0x04
+#define RTC_REG_DAY      0x07
+#define RTC_REG_MONTH    0x08
+#define RTC_REG_YEAR     0x09
+#define RTC_REG_STATUS_A 0x0A
+#define RTC_REG_STATUS_B 0x0B
+
+#define RTC_STATUS_A_UPDATING (1 << 7)
+#define RTC_STATUS_B_24_HOUR  (1 << 1)
+#define RTC_STATUS_B_BINARY   (1 << 2)
+#define RTC_HOUR_PM           (1 << 7)
+
+// Keeps NMIs disabled while a register is selected
+#define RTC_INDEX_NMI_DISABLE (1 << 7)
+
+namespace Kernel::Time
+{
+	static uint32_t from_bcd(uint32_t value)
+	{
+		return (value & 0x0F) + (value >> 4) * 10;
+	}
+
+	static bool is_leap_year(uint32_t year)
+	{
+		return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	}
+
+	uint64_t RTC::read_unix_time()
+	{
+		static constexpr uint32_t days_before_month[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+		date_time_t time = read_date_time();
+
+		uint64_t days = 0;
+
+		for (uint32_t year = 1970; year < time.year; year++)
+			days += is_leap_year(year) ? 366 : 365;
+
+		days += days_before_month[time.month - 1];
+
+		if (time.month > 2 && is_leap_year(time.year))
+			days++;
+
+		days += time.day - 1;
+
+		return ((days * 24 + time.hour) * 60 + time.minute) * 60 + time.second;
+	}
+
+	uint8_t RTC::read_register(uint8_t index)
+	{
+		m_index.out<uint8_t>(RTC_INDEX_NMI_DISABLE | index);
+		uint8_t value = m_data.in<uint8_t>();
+
+		// The index port also holds the NMI mask, so NMIs stay disabled until it is written without it
+		m_index.out<uint8_t>(index);
+
+		return value;
+	}
+
+	bool RTC::is_updating()
+	{
+		return read_register(RTC_REG_STATUS_A) & RTC_STATUS_A_UPDATING;
+	}
+
+	RTC::date_time_t RTC::read_date_time()
+	{
+		date_time_t time{};
+		date_time_t previous{};
+
+		// The registers are read until two reads in a row agree, so no update happened in between
+		do
+		{
+			previous = time;
+
+			while (is_updating())
+				;
+
+			time = {
+			    .second = read_register(RTC_REG_SECOND),
+			    .minute = read_register(RTC_REG_MINUTE),
+			    .hour = read_register(RTC_REG_HOUR),
+			    .day = read_register(RTC_REG_DAY),
+			    .month = read_register(RTC_REG_MONTH),
+			    .year = read_register(RTC_REG_YEAR),
+			};
+		} while (time.second != previous.second || time.minute != previous.minute || time.hour != previous.hour ||
+		         time.day != previous.day || time.month != previous.month || time.year != previous.year);
+
+		uint8_t status = read_register(RTC_REG_STATUS_B);
+		bool is_pm = time.hour & RTC_HOUR_PM;
+		time.hour &= ~RTC_HOUR_PM;
+
+		if (!(status & RTC_STATUS_B_BINARY))
+		{
+			time.second = from_bcd(time.second);
+			time.minute = from_bcd(time.minute);
+			time.hour = from_bcd(time.hour);
+			time.day = from_bcd(time.day);
+			time.month = from_bcd(time.month);
+			time.year = from_bcd(time.year);
+		}
+
+		if (!(status & RTC_STATUS_B_24_HOUR))
+			time.hour = (time.hour % 12) + (is_pm ? 12 : 0);
+
+		// The century register is not reliably available, two-digit years are assumed to be after 1970
+		time.year += time.year < 70 ? 2000 : 1900;
+
+		return time;
+	}
+} // namespace Kernel::Time
@@ -0,0 +1,59 @@
+#include <time/TimePage.hpp>
+
+#include <atomic>
+
+#include <arch/Processor.hpp>
+#include <memory/VirtualMemoryManager.hpp>
+#include <time/Clock.hpp>
+
+#include <libk/kcassert.hpp>
+#include <libk/kcstring.hpp>
+
+namespace Kernel::Time
+{
+	void TimePage::initialize()
+	{
+		assert(!m_page);
+
+		m_region = Memory::VirtualMemoryManager::instance().allocate_region(PAGE_SIZE);
+		memset(m_region.virt_region().pointer(), 0, PAGE_SIZE);
+
+		auto &clock = Clock::instance();
+		auto *page = static_cast<struct __time_page *>(m_region.virt_region().pointer());
+
+		page->uses_tsc = clock.uses_tsc();
+		page->tsc_shift = Clock::SCALE_SHIFT;
+		page->tsc_scale = clock.tsc_scale();
+		page->tsc_offset = clock.tsc_offset();
+		page->boot_time = clock.boot_time();
+
+		// The BSP timer updates the page as soon as it is visible, so it must not interrupt the first update
+		CPU::Processor::current().enter_critical();
+		m_page = page;
+		update();
+		CPU::Processor::current().leave_critical();
+	}
+
+	void TimePage::update()
+	{
+		if (!m_page)
+			return;
+
+		m_page->sequence++;
+		std::atomic_thread_fence(std::memory_order_release);
+
+		m_page->tick_time = Clock::instance().tick_time();
+
+		std::atomic_thread_fence(std::memory_order_release);
+		m_page->sequence++;
+	}
+
+	void TimePage::map()
+	{
+		assert(m_page);
+
+		// Fails without harm if the page is mapped already
+		auto config = Memory::mapping_config_t{.writeable = false, .userspace = true};
+		Memory::VirtualMemoryManager::instance().share_region_at(m_region.phys_address, __TIME_PAGE_ADDRESS, PAGE_SIZE, config);
+	}
+} // namespace Kernel::Time
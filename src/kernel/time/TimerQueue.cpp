@@ -0,0 +1,102 @@
+#include <time/TimerQueue.hpp>
+
+namespace Kernel::Time
+{
+	bool TimerQueue::insert(uint64_t nanoseconds, const LibK::function<void()> &callback)
+	{
+		m_heap.push_back({
+		    .deadline = m_now + nanoseconds,
+		    .slot = allocate_slot(callback),
+		});
+
+		return sift_up(m_heap.size() - 1) == 0;
+	}
+
+	bool TimerQueue::pop_expired(LibK::function<void()> &callback)
+	{
+		if (m_heap.empty() || m_heap.front().deadline > m_now)
+			return false;
+
+		uint32_t slot = m_heap.front().slot;
+
+		m_heap.front() = m_heap.back();
+		m_heap.pop_back();
+
+		if (!m_heap.empty())
+			sift_down(0);
+
+		callback = m_callbacks[slot];
+		m_callbacks[slot] = LibK::function<void()>();
+		m_free_slots.push_back(slot);
+
+		return true;
+	}
+
+	uint64_t TimerQueue::time_to_next() const
+	{
+		if (m_heap.empty() || m_heap.front().deadline <= m_now)
+			return 0;
+
+		return m_heap.front().deadline - m_now;
+	}
+
+	uint32_t TimerQueue::allocate_slot(const LibK::function<void()> &callback)
+	{
+		if (m_free_slots.empty())
+		{
+			m_callbacks.push_back(callback);
+			return m_callbacks.size() - 1;
+		}
+
+		uint32_t slot = m_free_slots.back();
+		m_free_slots.pop_back();
+		m_callbacks[slot] = callback;
+
+		return slot;
+	}
+
+	size_t TimerQueue::sift_up(size_t index)
+	{
+		entry_t entry = m_heap[index];
+
+		while (index > 0)
+		{
+			size_t parent = (index - 1) / 2;
+
+			if (m_heap[parent].deadline <= entry.deadline)
+				break;
+
+			m_heap[index] = m_heap[parent];
+			index = parent;
+		}
+
+		m_heap[index] = entry;
+
+		return index;
+	}
+
+	void TimerQueue::sift_down(size_t index)
+	{
+		entry_t entry = m_heap[index];
+		size_t size = m_heap.size();
+
+		while (true)
+		{
+			size_t child = index * 2 + 1;
+
+			if (child >= size)
+				break;
+
+			if (child + 1 < size && m_heap[child + 1].deadline < m_heap[child].deadline)
+				child++;
+
+			if (entry.deadline <= m_heap[child].deadline)
+				break;
+
+			m_heap[index] = m_heap[child];
+			index = child;
+		}
+
+		m_heap[index] = entry;
+	}
+} // namespace Kernel::Time
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <bits/guards.h>
+#include <stdint.h>
+
+// The kernel maps this page read-only into every process, right after the signal trampoline
+#define __TIME_PAGE_ADDRESS 0x2000
+
+__LIBC_BEGIN_DECLS
+
+// Everything the kernel knows about its clocks, so reading the time needs no syscall.
+// The kernel makes sequence odd while it writes to the page, readers retry until they saw the same even value before and after.
+struct __time_page
+{
+	uint32_t sequence;
+	uint32_t uses_tsc;
+
+	// Monotonic nanoseconds since boot = ((tsc >> tsc_shift) * tsc_scale) + (((tsc & low bits) * tsc_scale) >> tsc_shift) + tsc_offset
+	uint32_t tsc_shift;
+	uint32_t reserved;
+	uint64_t tsc_scale;
+	int64_t tsc_offset;
+
+	// Monotonic nanoseconds since boot as accounted by the timer interrupts, only updated without a TSC
+	uint64_t tick_time;
+
+	// Nanoseconds since the UNIX epoch at boot, added to the monotonic time for the wall clock
+	uint64_t boot_time;
+};
+
+__LIBC_END_DECLS
@@ -22,7 +22,9 @@
 	S(getcwd)             \
 	S(getdents)           \
 	S(sigaction)          \
-	S(sigreturn)
+	S(sigreturn)          \
+	S(clock_nanosleep)    \
+	S(clock_gettime)
 
 __LIBC_BEGIN_DECLS
 
@@ -0,0 +1,21 @@
+#include <sys/time.h>
+
+#include <__debug.h>
+
+#include <time.h>
+
+int gettimeofday(struct timeval *restrict tp, void *restrict tzp)
+{
+	TRACE("gettimeofday(%p, %p)\r\n", tp, tzp);
+
+	// There are no timezones, the clock runs on UTC
+	(void)tzp;
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	tp->tv_sec = now.tv_sec;
+	tp->tv_usec = now.tv_nsec / 1000;
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <bits/guards.h>
+#include <sys/types.h>
+
+__LIBC_BEGIN_DECLS
+
+struct timeval
+{
+	time_t      tv_sec;
+	suseconds_t tv_usec;
+};
+
+int gettimeofday(struct timeval *restrict tp, void *restrict tzp);
+
+__LIBC_END_DECLS
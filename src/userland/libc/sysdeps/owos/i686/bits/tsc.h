@@ -0,0 +1,15 @@
+#pragma once
+
+#include <bits/guards.h>
+#include <stdint.h>
+
+__LIBC_BEGIN_DECLS
+
+static inline uint64_t __read_tsc(void)
+{
+	uint32_t low, high;
+	__asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+	return ((uint64_t)high << 32) | low;
+}
+
+__LIBC_END_DECLS
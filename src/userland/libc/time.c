@@ -2,15 +2,87 @@
 
 #include <__debug.h>
 
-#include <stdio.h>
+#include <bits/time_page.h>
+#include <bits/tsc.h>
+#include <sys/syscall.h>
+
+#define NANOSECONDS_PER_SECOND 1000000000ull
+
+static const volatile struct __time_page *const s_time_page = (const volatile struct __time_page *)__TIME_PAGE_ADDRESS;
+
+// Reads the monotonic time and the boot time from the page the kernel keeps up to date, see bits/time_page.h
+static void read_time_page(uint64_t *monotonic, uint64_t *boot_time)
+{
+	uint32_t sequence;
+
+	do
+	{
+		sequence = s_time_page->sequence;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (s_time_page->uses_tsc)
+		{
+			uint64_t tsc = __read_tsc();
+			uint32_t shift = s_time_page->tsc_shift;
+			uint64_t scale = s_time_page->tsc_scale;
+
+			*monotonic = (tsc >> shift) * scale + (((tsc & ((1ull << shift) - 1)) * scale) >> shift) + s_time_page->tsc_offset;
+		}
+		else
+		{
+			*monotonic = s_time_page->tick_time;
+		}
+
+		*boot_time = s_time_page->boot_time;
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((sequence & 1) || sequence != s_time_page->sequence);
+}
+
+int clock_gettime(clockid_t clock_id, struct timespec *tp)
+{
+	TRACE("clock_gettime(%d, %p)\r\n", clock_id, tp);
+
+	// Other clocks and invalid arguments are left to the kernel
+	if ((clock_id != CLOCK_MONOTONIC && clock_id != CLOCK_REALTIME) || !tp)
+		return syscall(__SC_clock_gettime, clock_id, tp);
+
+	uint64_t monotonic, boot_time;
+	read_time_page(&monotonic, &boot_time);
+
+	uint64_t now = clock_id == CLOCK_REALTIME ? boot_time + monotonic : monotonic;
+
+	tp->tv_sec = now / NANOSECONDS_PER_SECOND;
+	tp->tv_nsec = now % NANOSECONDS_PER_SECOND;
+
+	return 0;
+}
+
+int clock_nanosleep(clockid_t clock_id, int flags, const struct timespec *rqtp, struct timespec *rmtp)
+{
+	TRACE("clock_nanosleep(%d, %d, %p, %p)\r\n", clock_id, flags, rqtp, rmtp);
+
+	// Unlike most functions, errors are returned instead of being stored in errno
+	uintptr_t ret = __syscall(__SC_clock_nanosleep, clock_id, flags, rqtp, rmtp);
+
+	return ret > -4096UL ? -ret : 0;
+}
+
+int nanosleep(const struct timespec *rqtp, struct timespec *rmtp)
+{
+	TRACE("nanosleep(%p, %p)\r\n", rqtp, rmtp);
+	return syscall(__SC_clock_nanosleep, CLOCK_REALTIME, 0, rqtp, rmtp);
+}
 
 time_t time(time_t *tloc)
 {
 	TRACE("time(%p)\r\n", tloc);
-	puts("time() not actually working! Set to 2023/01/01 00:00:00!");
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
 
 	if (tloc)
-		*tloc = 1672531200;
+		*tloc = now.tv_sec;
 
-	return 1672531200;
+	return now.tv_sec;
 }
@@ -4,6 +4,11 @@
 
 #include <sys/types.h>
 
+#define CLOCK_REALTIME  0
+#define CLOCK_MONOTONIC 1
+
+#define TIMER_ABSTIME 1
+
 __LIBC_BEGIN_DECLS
 
 struct tm
@@ -25,6 +30,9 @@ struct timespec
 	long   tv_nsec;
 };
 
+int    clock_gettime(clockid_t clock_id, struct timespec *tp);
+int    clock_nanosleep(clockid_t clock_id, int flags, const struct timespec *rqtp, struct timespec *rmtp);
+int    nanosleep(const struct timespec *rqtp, struct timespec *rmtp);
 time_t time(time_t *tloc);
 
 __LIBC_END_DECLS
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <time.h>
 
 char *optarg;
 int   opterr, optind, optopt;
@@ -152,7 +153,9 @@ int isatty(int fildes)
 unsigned sleep(unsigned seconds)
 {
 	TRACE("sleep(%u)\r\n", seconds);
-	(void)seconds;
-	puts("sleep() not implemented");
-	abort();
+
+	struct timespec request = {.tv_sec = seconds, .tv_nsec = 0};
+	nanosleep(&request, NULL);
+
+	return 0;
 }